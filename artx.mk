@@ -27,6 +27,10 @@ ARTX_SRC = src/task.c \
            src/spi.c \
            src/util.c \
            src/monitor.c \
+           src/sampling.c \
+           src/stack.c \
+           src/trace.c \
+           src/log.c \
            src/decimal.c \
            src/sleep.c \
            src/isr.c \
@@ -83,6 +87,14 @@ CFLAGS += $(patsubst %,-I%,$(EXTRAINCDIRS))
 CFLAGS += $(CSTANDARD)
 CFLAGS += -DF_OSC=$(F_OSC)
 
+# Registers r2 .. r(N+1) reserved from the compiler, see ARTX_FIXED_REGS.
+# Run 'make regscan' to check that no library code uses these registers.
+ifdef ARTX_FIXED_REGS
+  CFLAGS += $(patsubst %,-ffixed-r%,$(wordlist 1,$(ARTX_FIXED_REGS),\
+              2 3 4 5 6 7 8 9 10 11 12 13 14 15 16 17))
+  CFLAGS += -DARTX_FIXED_REGS=$(ARTX_FIXED_REGS)
+endif
+
 EXTRA_WARN = -Wunused -Wstrict-prototypes -Wmissing-prototypes -Werror
 # EXTRA_WARN =
 
@@ -207,6 +219,8 @@ OBJDUMP = avr-objdump
 SIZE = avr-size
 NM = avr-nm
 AVRDUDE = avrdude
+ARTX_TTGEN = $(ARTX_ROOT)/tools/artx-ttgen
+ARTX_REGSCAN = $(ARTX_ROOT)/tools/artx-regscan
 REMOVE = rm -f
 REMOVE_REC = rm -f -r
 COPY = cp
@@ -229,6 +243,8 @@ MSG_ARCHIVING = Archiving:
 MSG_COMPILING = Compiling:
 MSG_ASSEMBLING = Assembling:
 MSG_CLEANING = Cleaning project:
+MSG_TTGEN = Generating schedule table:
+MSG_REGSCAN = Scanning register usage:
 
 MSG_ARTX = \\033[1;36m
 MSG_USER = \\033[1;32m
@@ -243,6 +259,14 @@ OBJ = $(SRC:%.c=$(BUILDDIR)/%.o)
 # Define all listing files.
 LST = $(OBJ:%.o=%.lst)
 
+# Static schedule table for ARTX_SCHED_TABLE. Set TTABLE_SRC to the
+# source file containing the task declarations; the generated table
+# header is named after that file, e.g. main.c -> main_ttable.h.
+ifdef TTABLE_SRC
+  TTABLE = $(TTABLE_SRC:.c=_ttable.h)
+  $(OBJ): $(TTABLE)
+endif
+
 
 # Compiler flags to generate dependency files.
 ### GENDEPFLAGS = -Wp,-M,-MP,-MT,$(*F).o,-MF,.dep/$(@F).d
@@ -311,6 +335,16 @@ program: $(TARGET).hex $(TARGET).eep
 
 
 
+# Check register usage of the final binary against ARTX_FIXED_REGS.
+regscan: $(TARGET).elf
+	$(NEWLINE)
+	@echo -e "$(MSG_USER)$(MSG_REGSCAN) $<$(MSG_RESET)"
+	$(ECHO) $(ARTX_REGSCAN) --objdump $(OBJDUMP) \
+	  $(if $(ARTX_FIXED_REGS),-n $(ARTX_FIXED_REGS)) $<
+
+
+
+
 # Convert ELF to COFF for use in debugging / simulating in AVR Studio or VMLAB.
 COFFCONVERT=$(OBJCOPY) --debugging \
 --change-section-address .data-0x800000 \
@@ -381,6 +415,13 @@ $(BUILDDIR)/artx/src/%.o : $(ARTX_ROOT)/src/%.c
 	$(ECHO) $(CC) -c $(ALL_CFLAGS) $< -o $@
 
 
+# Generate static schedule table from task declarations.
+%_ttable.h : %.c $(ARTX_ROOT)/tools/artx-ttgen $(ARTX_ROOT)/tools/artxtasks.py
+	$(NEWLINE)
+	@echo -e "$(MSG_USER)$(MSG_TTGEN) $@$(MSG_RESET)"
+	$(ECHO) $(ARTX_TTGEN) $(TTGENFLAGS) -o $@ $<
+
+
 # Compile: create assembler files from C source files.
 %.s : %.c
 	$(CC) -S $(ALL_CFLAGS) $< -o $@
@@ -426,6 +467,7 @@ clean_list :
 	$(REMOVE) $(LST)
 	$(REMOVE) $(SRC:.c=.s)
 	$(REMOVE) $(SRC:.c=.d)
+	$(REMOVE) $(TTABLE)
 	$(REMOVE) .dep/*
 
 realclean_list :
@@ -446,4 +488,4 @@ gccconfig:
 # Listing of phony targets.
 .PHONY : all begin finish end sizebefore sizeafter gccversion \
 build elf hex eep lss sym coff extcoff \
-clean clean_list program
+clean clean_list program regscan
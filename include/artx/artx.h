@@ -107,9 +107,9 @@
  *  support.
  *
  *  It is possible to use this without #ARTX_ENABLE_SERIAL, however,
- *  it doesn't make much sense at the moment as the serial port is
- *  the only way to retrieve the monitoring information. This might
- *  change in future versions.
+ *  it only makes sense in combination with #ARTX_ENABLE_STATS, as
+ *  the serial port is otherwise the only way to retrieve the
+ *  monitoring information.
  *
  *  For obvious reasons, this feature consumes lots of flash, RAM
  *  and run-time. Each task and each routine needs to hold and
@@ -125,6 +125,317 @@
 # define ARTX_ENABLE_MONITOR      1
 #endif
 
+/**
+ *  Enable sampling monitor
+ *
+ *  \hideinitializer
+ *
+ *  Setting this to a nonzero value enables a lightweight alternative
+ *  to #ARTX_ENABLE_MONITOR. Instead of accounting every cycle, the
+ *  kernel samples the running task and routine once per tick, at a
+ *  pseudo-random point within the tick, and counts the samples per
+ *  task and routine. The share of samples is an unbiased estimate
+ *  of the share of CPU time. Task switches only cost a single store
+ *  per routine, the task control blocks only grow by a few bytes and
+ *  there's no separate context stack, so this can be left enabled in
+ *  production code.
+ *
+ *  The samples are taken by the compare B interrupt of the tick timer,
+ *  so this requires #ARTX_TIMER1_COMPARE as the tick source. The
+ *  sample counts are sent to the serial port every
+ *  #ARTX_SAMPLING_INTERVAL samples, so this also requires
+ *  #ARTX_ENABLE_SERIAL. This cannot be combined with
+ *  #ARTX_ENABLE_MONITOR.
+ *
+ *  Use tools/artx-sample to display the estimated load.
+ */
+#ifndef ARTX_ENABLE_SAMPLING
+# define ARTX_ENABLE_SAMPLING     0
+#endif
+
+/**
+ *  Sampling monitor interval
+ *
+ *  \hideinitializer
+ *
+ *  The number of samples, i.e. ticks, after which the sampling monitor
+ *  sends the sample counts. The statistical error of the estimated load
+ *  of a task is at most 50% divided by the square root of this value.
+ */
+#ifndef ARTX_SAMPLING_INTERVAL
+# define ARTX_SAMPLING_INTERVAL   1000
+#endif
+
+/**
+ *  Enable on-device statistics
+ *
+ *  \hideinitializer
+ *
+ *  Setting this to a nonzero value keeps a snapshot of the monitoring
+ *  information of each task from the last complete monitoring interval,
+ *  which the application can read using ARTX_stats_get_task() and
+ *  ARTX_stats_get_cpu_load(), e.g. to shed load when the CPU gets
+ *  busy. This requires #ARTX_ENABLE_MONITOR, but not
+ *  #ARTX_ENABLE_SERIAL. Snapshots are only taken while a monitoring
+ *  interval is set using ARTX_monitor_set_interval(). As they are
+ *  taken by the idle task, they go stale when the CPU is overloaded,
+ *  which can be detected using ARTX_stats_get_age().
+ */
+#ifndef ARTX_ENABLE_STATS
+# define ARTX_ENABLE_STATS        0
+#endif
+
+/**
+ *  Enable stack checking
+ *
+ *  \hideinitializer
+ *
+ *  Setting this to a nonzero value fills each task's stack with a
+ *  sentinel pattern when the task is set up and keeps track of how
+ *  much of it has never been used. The application can query this
+ *  using ARTX_stack_get_free() or check all tasks at once using
+ *  ARTX_stack_check(), e.g. from a low priority task.
+ *
+ *  Unlike #ARTX_ENABLE_MONITOR, this only adds 6 bytes to each task
+ *  control block and doesn't add anything to task switches, so it
+ *  can be left enabled in production code. It can also be combined
+ *  with #ARTX_ENABLE_MONITOR, in which case both use the same
+ *  watermark.
+ */
+#ifndef ARTX_ENABLE_STACK_CHECK
+# define ARTX_ENABLE_STACK_CHECK  0
+#endif
+
+/**
+ *  Stack scan budget
+ *
+ *  \hideinitializer
+ *
+ *  The maximum number of stack bytes that are looked at whenever the
+ *  stack watermark of a task is updated, either by the monitor or by
+ *  #ARTX_ENABLE_STACK_CHECK. Scanning starts right below the last
+ *  known watermark and continues where it stopped the next time, so
+ *  this limits the time spent per task, and the time the scheduler is
+ *  locked during the scan, independent of the stack size.
+ */
+#ifndef ARTX_STACK_SCAN_BUDGET
+# define ARTX_STACK_SCAN_BUDGET   32
+#endif
+
+/**
+ *  Stack check margin
+ *
+ *  \hideinitializer
+ *
+ *  The number of never used stack bytes below which ARTX_stack_check()
+ *  reports a task as running low on stack space.
+ */
+#ifndef ARTX_STACK_CHECK_MARGIN
+# define ARTX_STACK_CHECK_MARGIN  16
+#endif
+
+/**
+ *  Enable execution time histograms
+ *
+ *  \hideinitializer
+ *
+ *  Setting this to a nonzero value makes the monitor keep a histogram
+ *  of the cycles spent in each run of a task or routine, in addition
+ *  to the average and peak values. This reveals routines with more
+ *  than one typical execution time as well as rare long runs. The
+ *  histograms are sent along with the monitoring information, so this
+ *  requires #ARTX_ENABLE_MONITOR.
+ */
+#ifndef ARTX_ENABLE_HISTOGRAM
+# define ARTX_ENABLE_HISTOGRAM    0
+#endif
+
+/**
+ *  Number of execution time histogram bins
+ *
+ *  \hideinitializer
+ *
+ *  The histograms are logarithmic. The first bin counts all runs
+ *  shorter than 2^#ARTX_HISTOGRAM_SHIFT timer units, each further bin
+ *  doubles the limit, and the last bin counts all longer runs. Each
+ *  bin uses 2 bytes of RAM per task and routine. This must be between
+ *  2 and 16.
+ */
+#ifndef ARTX_HISTOGRAM_BINS
+# define ARTX_HISTOGRAM_BINS      12
+#endif
+
+/**
+ *  Execution time histogram resolution
+ *
+ *  \hideinitializer
+ *
+ *  The limit of the first histogram bin is 2 to the power of this
+ *  value in units of the timer used as the tick source.
+ */
+#ifndef ARTX_HISTOGRAM_SHIFT
+# define ARTX_HISTOGRAM_SHIFT     5
+#endif
+
+/**
+ *  Enable release latency statistics
+ *
+ *  \hideinitializer
+ *
+ *  Setting this to a nonzero value makes the monitor record, for each
+ *  task, how late it starts after being released (start latency) and
+ *  how late it completes (response time), relative to the tick at which
+ *  it was released. Minimum, maximum and mean of both are sent along
+ *  with the monitoring information, so this requires
+ *  #ARTX_ENABLE_MONITOR. As the time since the release is derived from
+ *  the task's schedule, this cannot be combined with #ARTX_SCHED_TABLE.
+ *
+ *  Use tools/artx-latency to display the statistics or to check them
+ *  against limits.
+ */
+#ifndef ARTX_ENABLE_LATENCY
+# define ARTX_ENABLE_LATENCY      0
+#endif
+
+/**
+ *  Enable program counter sampling
+ *
+ *  \hideinitializer
+ *
+ *  Setting this to a nonzero value makes the tick record the address
+ *  at which the current task was interrupted in a small histogram.
+ *  The histogram is sent along with the monitoring information at the
+ *  end of each monitoring interval, so this requires
+ *  #ARTX_ENABLE_MONITOR.
+ *
+ *  Use tools/artx-prof together with the application's ELF file to
+ *  turn the samples into a flat profile of the functions the tasks
+ *  spend their time in.
+ */
+#ifndef ARTX_ENABLE_PROFILE
+# define ARTX_ENABLE_PROFILE      0
+#endif
+
+/**
+ *  Program counter histogram size
+ *
+ *  \hideinitializer
+ *
+ *  The number of distinct addresses the histogram can hold during a
+ *  single monitoring interval. Each entry uses 4 bytes of RAM, and
+ *  two histograms are allocated. This must be a power of two between
+ *  2 and 128. Samples that do not fit are reported separately.
+ */
+#ifndef ARTX_PROFILE_SIZE
+# define ARTX_PROFILE_SIZE        32
+#endif
+
+/**
+ *  Enable interrupt disabled window profiling
+ *
+ *  \hideinitializer
+ *
+ *  Setting this to a nonzero value makes ARTX_lock(), ARTX_unlock(),
+ *  ARTX_disable_int() and ARTX_enable_int() measure how long interrupts
+ *  stay disabled, using the tick timer. The same is done for the
+ *  kernel's task switch path. For each site that disabled interrupts,
+ *  the longest window and a histogram of the window durations are
+ *  kept and sent along with the monitoring information, so this
+ *  requires #ARTX_ENABLE_MONITOR.
+ *
+ *  Use tools/artx-cliprof together with the application's ELF file
+ *  to find the sites that determine the worst-case interrupt latency.
+ *
+ *  Windows in the kernel's task switch path are measured from after
+ *  the task's context has been saved to before it is restored. Time
+ *  spent in interrupt service routines is not measured, but reported
+ *  per routine by the monitor. Note that the measurement itself makes
+ *  each window a little longer.
+ */
+#ifndef ARTX_ENABLE_CLI_PROFILE
+# define ARTX_ENABLE_CLI_PROFILE  0
+#endif
+
+/**
+ *  Number of interrupt disabled window sites
+ *
+ *  \hideinitializer
+ *
+ *  The number of distinct sites for which interrupt disabled windows
+ *  are recorded. Each site uses 20 bytes of RAM. This must be a power
+ *  of two between 2 and 64. Windows of further sites are only counted.
+ */
+#ifndef ARTX_CLI_SITES
+# define ARTX_CLI_SITES           8
+#endif
+
+/**
+ *  Enable event tracing
+ *
+ *  \hideinitializer
+ *
+ *  Setting this to a nonzero value makes the kernel record task
+ *  switches, task releases, kernel ticks, the start and end of each
+ *  routine and the entry and exit of interrupt service routines
+ *  declared using ARTX_ISR() in a ring buffer in RAM. Each event is
+ *  stamped with the value of the tick timer, i.e. the time since the
+ *  last tick. The idle task sends the recorded events via the serial
+ *  port, so this is only useful with #ARTX_ENABLE_SERIAL.
+ *
+ *  Use tools/artx-trace to turn the recorded events into a timeline
+ *  that can be viewed in Chrome's trace viewer or Perfetto.
+ *
+ *  Events are dropped while the buffer is full, so make sure the
+ *  idle task gets enough time and the serial port is fast enough.
+ *  Lost events are reported by the tool.
+ */
+#ifndef ARTX_ENABLE_TRACE
+# define ARTX_ENABLE_TRACE        0
+#endif
+
+/**
+ *  Trace buffer size
+ *
+ *  \hideinitializer
+ *
+ *  The number of events the trace buffer can hold. Each event uses
+ *  5 bytes of RAM. This must be a power of two between 2 and 128.
+ */
+#ifndef ARTX_TRACE_SIZE
+# define ARTX_TRACE_SIZE          32
+#endif
+
+/**
+ *  Enable binary logging
+ *
+ *  \hideinitializer
+ *
+ *  Setting this to a nonzero value enables ARTX_LOG(). Rather than
+ *  formatting log messages on the target, only the address of the
+ *  format string and the raw argument bytes are stored in a ring
+ *  buffer in RAM. The idle task sends the stored messages via the
+ *  serial port, so this is only useful with #ARTX_ENABLE_SERIAL.
+ *
+ *  Use tools/artx-log together with the application's ELF file to
+ *  turn the messages back into text.
+ */
+#ifndef ARTX_ENABLE_LOG
+# define ARTX_ENABLE_LOG          0
+#endif
+
+/**
+ *  Log buffer size
+ *
+ *  \hideinitializer
+ *
+ *  The size of the log buffer in bytes. Each message uses 3 bytes
+ *  plus the size of its arguments. This must be a power of two
+ *  between 32 and 128.
+ */
+#ifndef ARTX_LOG_SIZE
+# define ARTX_LOG_SIZE            64
+#endif
+
 /**
  *  Routines hold state information
  *
@@ -157,6 +468,338 @@
 # define ARTX_USE_MULTI_ROUT      1
 #endif
 
+/**
+ *  Earliest deadline first scheduling
+ *
+ *  \hideinitializer
+ *
+ *  Setting this to a nonzero value makes the scheduler pick the
+ *  released task with the earliest absolute deadline instead of
+ *  the released task with the highest priority. The deadline of
+ *  a task is the end of its current interval, i.e. the point in
+ *  time when it will be released again. Task priorities are only
+ *  used to break ties between tasks with the same deadline.
+ *
+ *  Released tasks are kept in a list sorted by deadline, so the
+ *  scheduler itself doesn't need to search for the next task.
+ *  The cost is moved to the tick, which has to insert each task
+ *  into the list when it is released.
+ */
+#ifndef ARTX_SCHED_EDF
+# define ARTX_SCHED_EDF           0
+#endif
+
+/**
+ *  Time-triggered schedule table
+ *
+ *  \hideinitializer
+ *
+ *  Setting this to a nonzero value replaces the per-tick update of
+ *  all task schedules with a static schedule table stored in flash.
+ *  The table covers one hyperperiod of all tasks and holds, for each
+ *  tick at which at least one task is released, the set of released
+ *  tasks and the number of ticks until the next such tick. Offsets
+ *  larger than the interval of a task add a start-up part to the
+ *  table that is only run once. The kernel
+ *  tick then only counts down to the next table entry instead of
+ *  walking the whole task list.
+ *
+ *  The table must be generated offline from the task declarations
+ *  using tools/artx-ttgen and included in exactly one source file
+ *  after all tasks have been declared. Task intervals and offsets
+ *  are fixed at build time, so ARTX_task_set_interval() must not be
+ *  used in this mode.
+ */
+#ifndef ARTX_SCHED_TABLE
+# define ARTX_SCHED_TABLE         0
+#endif
+
+/**
+ *  Maximum number of tasks in schedule table
+ *
+ *  \hideinitializer
+ *
+ *  The maximum number of tasks that can be released by the static
+ *  schedule table. This determines the size of each table entry:
+ *  up to 8 tasks use 3 bytes, up to 16 tasks use 4 bytes and up
+ *  to 32 tasks use 6 bytes per entry.
+ */
+#ifndef ARTX_SCHED_TABLE_TASKS
+# define ARTX_SCHED_TABLE_TASKS   8
+#endif
+
+/**
+ *  Enable operating modes
+ *
+ *  \hideinitializer
+ *
+ *  Setting this to a nonzero value allows you to declare operating
+ *  modes using #ARTX_MODE. Each mode defines a set of active tasks
+ *  along with their intervals and offsets. Switching to a different
+ *  mode using ARTX_mode_switch() replaces the kernel's task list at
+ *  the next tick, so tasks that are not part of the current mode
+ *  don't cost any run-time at all.
+ */
+#ifndef ARTX_ENABLE_MODES
+# define ARTX_ENABLE_MODES        0
+#endif
+
+/**
+ *  Tasks can be suspended
+ *
+ *  \hideinitializer
+ *
+ *  Setting this to a nonzero value enables ARTX_task_suspend() and
+ *  ARTX_task_resume(). A suspended task is removed from the kernel's
+ *  task list, so unlike a task with only disabled routines, it isn't
+ *  released, scheduled or updated by the tick at all.
+ *
+ *  This adds 5 bytes of RAM to each task and a 32-bit tick counter
+ *  that is incremented by the tick.
+ */
+#ifndef ARTX_USE_TASK_SUSPEND
+# define ARTX_USE_TASK_SUSPEND    0
+#endif
+
+/**
+ *  Task pool size
+ *
+ *  \hideinitializer
+ *
+ *  Setting this to a nonzero value reserves a pool of task control
+ *  blocks and stacks for tasks that are created at run-time using
+ *  ARTX_task_create() and terminated using ARTX_task_exit(). The
+ *  value is the maximum number of such tasks running at the same
+ *  time.
+ */
+#ifndef ARTX_TASK_POOL_SIZE
+# define ARTX_TASK_POOL_SIZE      0
+#endif
+
+/**
+ *  Enable execution budgets
+ *
+ *  \hideinitializer
+ *
+ *  Setting this to a nonzero value allows you to assign an execution
+ *  budget to each task using ARTX_task_set_budget(). When a task has
+ *  used up its budget during a single release, it is deferred until
+ *  its next release and its overrun counter is incremented. This
+ *  keeps a runaway task from starving all tasks of lower priority.
+ *
+ *  The budget is checked by the tick, so a task can exceed its
+ *  budget by up to one tick interval. Each task uses an extra 10
+ *  bytes of RAM.
+ */
+#ifndef ARTX_ENABLE_BUDGET
+# define ARTX_ENABLE_BUDGET       0
+#endif
+
+/**
+ *  Enable sporadic servers
+ *
+ *  \hideinitializer
+ *
+ *  Setting this to a nonzero value allows you to turn tasks into
+ *  sporadic servers using ARTX_sporadic_init(). A sporadic server
+ *  handles aperiodic requests posted using ARTX_sporadic_request().
+ *  It runs at its own priority, but only for as long as its capacity
+ *  lasts. Each chunk of capacity used by the server is replenished
+ *  one interval of the task after the server became ready to use it,
+ *  so the server can never use more than its capacity within any
+ *  window of one interval, no matter how many requests arrive.
+ *  Servers that have no pending requests are not part of the task
+ *  list.
+ *
+ *  Sporadic servers require #ARTX_ENABLE_BUDGET, which is used to
+ *  enforce the capacity.
+ */
+#ifndef ARTX_ENABLE_SPORADIC
+# define ARTX_ENABLE_SPORADIC     0
+#endif
+
+/**
+ *  Number of pending replenishments per sporadic server
+ *
+ *  \hideinitializer
+ *
+ *  The maximum number of chunks of used capacity a sporadic server
+ *  keeps track of until they are replenished. If a server uses more
+ *  chunks within one interval, the latest chunk is merged with the
+ *  previous one, which delays the replenishment of the latter. Each
+ *  entry uses 8 bytes of RAM per task.
+ */
+#ifndef ARTX_SPORADIC_REPLENISHMENTS
+# define ARTX_SPORADIC_REPLENISHMENTS 2
+#endif
+
+/**
+ *  Initialize tasks automatically
+ *
+ *  \hideinitializer
+ *
+ *  Setting this to a nonzero value makes each task declared using
+ *  #ARTX_TASK, #ARTX_TASK_OFFS or #ARTX_IDLE_TASK register itself
+ *  in the \c .init7 section of the startup code, so all tasks are
+ *  initialized before main() is called and you must not call
+ *  ARTX_task_init() for them. In the same way, #ARTX_TASK_ROUT can
+ *  be used to add routines to a task from the \c .init8 section.
+ *
+ *  This makes it impossible to forget initializing a task, and it
+ *  allows tasks to be declared in any number of source files without
+ *  having to export them.
+ */
+#ifndef ARTX_USE_AUTO_INIT
+# define ARTX_USE_AUTO_INIT       0
+#endif
+
+/**
+ *  Keep constant task data in flash
+ *
+ *  \hideinitializer
+ *
+ *  Setting this to a nonzero value moves the routine, interval and
+ *  priority of each task into flash, leaving only the stack pointer,
+ *  list pointer, schedule and a pointer to the constant data in RAM.
+ *  This saves 3 bytes of RAM per task. Tasks must then be declared
+ *  using #ARTX_ROM_TASK, #ARTX_ROM_TASK_OFFS and #ARTX_ROM_IDLE_TASK,
+ *  which take the task's routine as an additional argument.
+ *
+ *  As the task configuration can no longer be changed at run-time,
+ *  this option cannot be combined with #ARTX_USE_MULTI_ROUT,
+ *  #ARTX_ENABLE_MODES, #ARTX_USE_TASK_SUSPEND, #ARTX_TASK_POOL_SIZE
+ *  or #ARTX_ENABLE_SPORADIC. It also cannot be combined with
+ *  #ARTX_ENABLE_MONITOR, which needs the full TCB in RAM.
+ */
+#ifndef ARTX_USE_ROM_TCB
+# define ARTX_USE_ROM_TCB         0
+#endif
+
+/**
+ *  Use 8-bit schedules
+ *
+ *  \hideinitializer
+ *
+ *  Setting this to a nonzero value reduces each task's schedule and
+ *  interval to 8 bits, saving 1 byte of RAM per task (2 bytes without
+ *  #ARTX_USE_ROM_TCB) and a few cycles per task in every tick. All
+ *  intervals and offsets must then be less than 128 ticks.
+ *
+ *  This option cannot be combined with #ARTX_USE_ABS_RELEASE.
+ */
+#ifndef ARTX_USE_SHORT_SCHEDULE
+# define ARTX_USE_SHORT_SCHEDULE  0
+#endif
+
+/**
+ *  Number of registers reserved from the compiler
+ *
+ *  \hideinitializer
+ *
+ *  Setting this to a nonzero value N excludes the registers r2 up to
+ *  r(N+1) from the task context, which saves N bytes of stack per task
+ *  and 4*N cycles per context switch. This is only safe if no code in
+ *  the application ever uses these registers, so all code must be
+ *  compiled with \c -ffixed-r2 ... \c -ffixed-r(N+1).
+ *
+ *  Don't set this in your configuration header. Instead, set the
+ *  \c ARTX_FIXED_REGS variable when using artx.mk, which passes both
+ *  the compiler flags and this define. As precompiled library code
+ *  (e.g. from avr-libc or libgcc) may still use these registers, run
+ *  <tt>make regscan</tt> to check the final binary using
+ *  tools/artx-regscan, which also reports how many registers could
+ *  be reserved for a given binary.
+ *
+ *  Valid values range from 0 to 16.
+ */
+#ifndef ARTX_FIXED_REGS
+# define ARTX_FIXED_REGS          0
+#endif
+
+/**
+ *  Keep kernel state in general purpose I/O registers
+ *
+ *  \hideinitializer
+ *
+ *  Setting this to a nonzero value makes the kernel keep the tick
+ *  indicator in bit 0 of \c GPIOR0 instead of SRAM. It's set and
+ *  cleared using \c sbi / \c cbi and tested using \c sbis, which
+ *  saves about 3 cycles per task switch. With #ARTX_ENABLE_MONITOR,
+ *  the kernel also uses \c GPIOR1 and \c GPIOR2 as scratch space
+ *  while switching to the context stack, saving another 8 cycles.
+ *
+ *  The application must not use these registers (or bit 0 of
+ *  \c GPIOR0). This option is only available on devices that
+ *  have general purpose I/O registers.
+ */
+#ifndef ARTX_USE_GPIOR
+# define ARTX_USE_GPIOR           0
+#endif
+
+/**
+ *  Run interrupt service routines on the kernel stack
+ *
+ *  \hideinitializer
+ *
+ *  By default, ARTX_ISR() is just an alias for \c ISR(), so each
+ *  interrupt service routine runs on the stack of whichever task it
+ *  interrupted. Every task's stack size must then include the stack
+ *  usage of the deepest interrupt service routine, and with
+ *  #ARTX_ENABLE_MONITOR, the stack usage reported for a task includes
+ *  the interrupt frames.
+ *
+ *  Setting this to a nonzero value makes interrupt service routines
+ *  declared using ARTX_ISR() switch to the kernel stack, which is
+ *  otherwise only used during task switches. Only the return address
+ *  is pushed onto the task stack, which is already accounted for by
+ *  the kernel. The wrapper only saves the call-used registers, all
+ *  other registers are saved by the routine itself as needed.
+ *
+ *  Interrupt service routines declared using ARTX_ISR() must not
+ *  enable interrupts, and interrupts must not be enabled before
+ *  ARTX_schedule() is called.
+ */
+#ifndef ARTX_ENABLE_ISR_STACK
+# define ARTX_ENABLE_ISR_STACK    0
+#endif
+
+/**
+ *  Use absolute release times
+ *
+ *  \hideinitializer
+ *
+ *  By default, each task's schedule is a 16-bit counter that is
+ *  decremented by every tick. This limits intervals and offsets to
+ *  32767 ticks, and a task that is stalled for more than 32768 ticks
+ *  loses track of how many releases it has missed.
+ *
+ *  Setting this to a nonzero value stores the absolute tick of the
+ *  next release in an unsigned 32-bit value instead, which is compared
+ *  against a global tick counter using wrap-safe arithmetic. This lifts
+ *  both limits and the tick no longer needs to update every task. Only
+ *  with #ARTX_SCHED_EDF, the tick still walks the task list to find
+ *  newly released tasks. On the downside, each TCB uses 4 more bytes
+ *  of RAM and the scheduler has to do 32-bit compares.
+ *
+ *  This option cannot be combined with #ARTX_SCHED_TABLE, which
+ *  doesn't use per-task schedules at all.
+ */
+#ifndef ARTX_USE_ABS_RELEASE
+# define ARTX_USE_ABS_RELEASE     0
+#endif
+
+/**
+ *  Task pool stack size
+ *
+ *  \hideinitializer
+ *
+ *  The user stack size in bytes of each task in the task pool. The
+ *  stack overhead required by the kernel will be added automatically.
+ */
+#ifndef ARTX_TASK_POOL_STACK_SIZE
+# define ARTX_TASK_POOL_STACK_SIZE  32
+#endif
+
 /**
  *  Lock calls can be nested
  *
@@ -239,6 +882,127 @@
 # error "ARTX_USE_ROUT_STATE requires ARTX_USE_MULTI_ROUT"
 #endif
 
+#if ARTX_SCHED_TABLE && ARTX_SCHED_EDF
+# error "ARTX_SCHED_TABLE cannot be combined with ARTX_SCHED_EDF"
+#endif
+
+#if ARTX_SCHED_TABLE && (ARTX_SCHED_TABLE_TASKS < 1 || ARTX_SCHED_TABLE_TASKS > 32)
+# error "ARTX_SCHED_TABLE_TASKS must be between 1 and 32"
+#endif
+
+#if ARTX_ENABLE_MODES && ARTX_SCHED_TABLE
+# error "ARTX_ENABLE_MODES cannot be combined with ARTX_SCHED_TABLE"
+#endif
+
+#if ARTX_USE_TASK_SUSPEND && ARTX_SCHED_TABLE
+# error "ARTX_USE_TASK_SUSPEND cannot be combined with ARTX_SCHED_TABLE"
+#endif
+
+#if ARTX_ENABLE_SPORADIC && !ARTX_ENABLE_BUDGET
+# error "ARTX_ENABLE_SPORADIC requires ARTX_ENABLE_BUDGET"
+#endif
+
+#if ARTX_ENABLE_SPORADIC && ARTX_SCHED_TABLE
+# error "ARTX_ENABLE_SPORADIC cannot be combined with ARTX_SCHED_TABLE"
+#endif
+
+#if ARTX_ENABLE_SPORADIC && (ARTX_SPORADIC_REPLENISHMENTS < 1 || ARTX_SPORADIC_REPLENISHMENTS > 127)
+# error "ARTX_SPORADIC_REPLENISHMENTS must be between 1 and 127"
+#endif
+
+#if ARTX_USE_ABS_RELEASE && ARTX_SCHED_TABLE
+# error "ARTX_USE_ABS_RELEASE cannot be combined with ARTX_SCHED_TABLE"
+#endif
+
+#if ARTX_FIXED_REGS < 0 || ARTX_FIXED_REGS > 16
+# error "ARTX_FIXED_REGS must be between 0 and 16"
+#endif
+
+#if ARTX_USE_SHORT_SCHEDULE && ARTX_USE_ABS_RELEASE
+# error "ARTX_USE_SHORT_SCHEDULE cannot be combined with ARTX_USE_ABS_RELEASE"
+#endif
+
+#if ARTX_USE_ROM_TCB && ARTX_USE_MULTI_ROUT
+# error "ARTX_USE_ROM_TCB cannot be combined with ARTX_USE_MULTI_ROUT"
+#endif
+
+#if ARTX_USE_ROM_TCB && ARTX_ENABLE_MONITOR
+# error "ARTX_USE_ROM_TCB cannot be combined with ARTX_ENABLE_MONITOR"
+#endif
+
+#if ARTX_USE_ROM_TCB && (ARTX_ENABLE_MODES || ARTX_USE_TASK_SUSPEND || \
+                         ARTX_TASK_POOL_SIZE || ARTX_ENABLE_SPORADIC)
+# error "ARTX_USE_ROM_TCB cannot be combined with run-time task configuration"
+#endif
+
+#if ARTX_ENABLE_SAMPLING && ARTX_ENABLE_MONITOR
+# error "ARTX_ENABLE_SAMPLING cannot be combined with ARTX_ENABLE_MONITOR"
+#endif
+
+#if ARTX_ENABLE_SAMPLING && !ARTX_ENABLE_SERIAL
+# error "ARTX_ENABLE_SAMPLING requires ARTX_ENABLE_SERIAL"
+#endif
+
+#if ARTX_ENABLE_SAMPLING && (ARTX_SAMPLING_INTERVAL < 1 || ARTX_SAMPLING_INTERVAL > 65535)
+# error "ARTX_SAMPLING_INTERVAL must be between 1 and 65535"
+#endif
+
+#if ARTX_ENABLE_STATS && !ARTX_ENABLE_MONITOR
+# error "ARTX_ENABLE_STATS requires ARTX_ENABLE_MONITOR"
+#endif
+
+#if ARTX_STACK_SCAN_BUDGET < 1 || ARTX_STACK_SCAN_BUDGET > 65535
+# error "ARTX_STACK_SCAN_BUDGET must be between 1 and 65535"
+#endif
+
+#if ARTX_ENABLE_HISTOGRAM && !ARTX_ENABLE_MONITOR
+# error "ARTX_ENABLE_HISTOGRAM requires ARTX_ENABLE_MONITOR"
+#endif
+
+#if ARTX_ENABLE_HISTOGRAM && (ARTX_HISTOGRAM_BINS < 2 || ARTX_HISTOGRAM_BINS > 16)
+# error "ARTX_HISTOGRAM_BINS must be between 2 and 16"
+#endif
+
+#if ARTX_ENABLE_LATENCY && !ARTX_ENABLE_MONITOR
+# error "ARTX_ENABLE_LATENCY requires ARTX_ENABLE_MONITOR"
+#endif
+
+#if ARTX_ENABLE_LATENCY && ARTX_SCHED_TABLE
+# error "ARTX_ENABLE_LATENCY cannot be combined with ARTX_SCHED_TABLE"
+#endif
+
+#if ARTX_ENABLE_PROFILE && !ARTX_ENABLE_MONITOR
+# error "ARTX_ENABLE_PROFILE requires ARTX_ENABLE_MONITOR"
+#endif
+
+#if ARTX_ENABLE_PROFILE && (ARTX_PROFILE_SIZE < 2 || ARTX_PROFILE_SIZE > 128 || \
+                            (ARTX_PROFILE_SIZE & (ARTX_PROFILE_SIZE - 1)))
+# error "ARTX_PROFILE_SIZE must be a power of two between 2 and 128"
+#endif
+
+#if ARTX_ENABLE_CLI_PROFILE && !ARTX_ENABLE_MONITOR
+# error "ARTX_ENABLE_CLI_PROFILE requires ARTX_ENABLE_MONITOR"
+#endif
+
+#if ARTX_ENABLE_CLI_PROFILE && (ARTX_CLI_SITES < 2 || ARTX_CLI_SITES > 64 || \
+                                (ARTX_CLI_SITES & (ARTX_CLI_SITES - 1)))
+# error "ARTX_CLI_SITES must be a power of two between 2 and 64"
+#endif
+
+#if ARTX_ENABLE_TRACE && (ARTX_TRACE_SIZE < 2 || ARTX_TRACE_SIZE > 128 || \
+                          (ARTX_TRACE_SIZE & (ARTX_TRACE_SIZE - 1)))
+# error "ARTX_TRACE_SIZE must be a power of two between 2 and 128"
+#endif
+
+#if ARTX_ENABLE_LOG && (ARTX_LOG_SIZE < 32 || ARTX_LOG_SIZE > 128 || \
+                        (ARTX_LOG_SIZE & (ARTX_LOG_SIZE - 1)))
+# error "ARTX_LOG_SIZE must be a power of two between 32 and 128"
+#endif
+
+#if ARTX_TASK_POOL_SIZE && ARTX_SCHED_TABLE
+# error "ARTX_TASK_POOL_SIZE cannot be combined with ARTX_SCHED_TABLE"
+#endif
+
 /**
  *  System clock frequency
  *
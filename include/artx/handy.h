@@ -73,6 +73,17 @@
  */
 #define artxNAKED          __attribute__((naked))
 
+/**
+ *  Declare function as startup code
+ *
+ *  \internal
+ *
+ *  The function will be placed in the given \c .initN section and
+ *  run as part of the startup code before main() is called. It must
+ *  not return, which is why it is naked.
+ */
+#define artxINITSECTION(n) __attribute__((naked, used, section(".init" #n)))
+
 /**
  *  Static assertion
  *
@@ -36,48 +36,156 @@
 
 #include "artx/artx.h"
 #include "artx/handy.h"
+#include "artx/monitor.h"
+#include "artx/trace.h"
 
-#if 0 && ARTX_ENABLE_MONITOR
+#if ARTX_ENABLE_MONITOR
 
-extern uint8_t artx_REG;
-extern uint8_t artx_SPL;
-extern uint8_t artx_SPH;
+/**
+ *  Declare interrupt service routine cycle accounting
+ *
+ *  \internal
+ *  \hideinitializer
+ *
+ *  This macro declares the cycle accounting of routine \a isr and
+ *  links it into the list of routines during startup.
+ */
+# define artx_ISR_MONITOR_DECL_(isr, name_str)                          \
+                                                                        \
+static const char isr ## _name[] PROGMEM = name_str;                    \
+                                                                        \
+static struct artx_monitor_account isr ## _mon = {                      \
+  .name = &isr ## _name[0]                                              \
+};                                                                      \
+                                                                        \
+static artxINITSECTION(7) void isr ## _link(void)                       \
+{                                                                       \
+  isr ## _mon.next = artx_monitor_isr_list;                             \
+  artx_monitor_isr_list = &isr ## _mon;                                 \
+}
 
-void artx_call_isr(void (*isr)(void)) artxNAKED;
+# define artx_ISR_RUN_(isr)                                             \
+          artx_monitor_run_isr(&isr ## _mon, &isr ## _body)
 
-# define ARTX_ISR(the_isr)                                              \
+#else // !ARTX_ENABLE_MONITOR
+
+# define artx_ISR_MONITOR_DECL_(isr, name_str)
+# define artx_ISR_RUN_(isr)                 isr ## _body()
+
+#endif // ARTX_ENABLE_MONITOR
+
+#if ARTX_ENABLE_MONITOR || ARTX_ENABLE_TRACE
+
+/**
+ *  Define interrupt service routine entry point
+ *
+ *  \internal
+ *  \hideinitializer
+ *
+ *  This macro defines \a isr as the routine to be run by the
+ *  interrupt vector. With monitoring support, the actual routine
+ *  is run through artx_monitor_run_isr(). With event tracing, the
+ *  entry and exit of the routine is recorded. The macro must be
+ *  directly followed by the body of the actual routine.
+ *
+ *  \param isr                   Name of the routine.
+ *
+ *  \param name_str              Name reported by the monitor.
+ */
+# define artx_ISR_ROUTINE_(isr, name_str)                               \
                                                                         \
-static void artx_isr_ ## the_isr(void);                                 \
+static void isr ## _body(void);                                         \
                                                                         \
-ISR(the_isr) artxNAKED;                                                 \
+artx_ISR_MONITOR_DECL_(isr, name_str)                                   \
                                                                         \
-ISR(the_isr)                                                            \
+static void isr(void)                                                   \
+{                                                                       \
+  artx_TRACE(artx_TE_ISR_ENTER, &isr ## _body);                         \
+  artx_ISR_RUN_(isr);                                                   \
+  artx_TRACE(artx_TE_ISR_EXIT, &isr ## _body);                          \
+}                                                                       \
+                                                                        \
+static void isr ## _body(void)
+
+#else // !(ARTX_ENABLE_MONITOR || ARTX_ENABLE_TRACE)
+
+# define artx_ISR_ROUTINE_(isr, name_str)   static void isr(void)
+
+#endif // ARTX_ENABLE_MONITOR || ARTX_ENABLE_TRACE
+
+#if ARTX_ENABLE_ISR_STACK
+
+extern uint8_t artx_isr_R31;
+extern uint16_t artx_isr_SP;
+
+void artx_call_isr(void) artxNAKED;
+
+/**
+ *  Declare an interrupt service routine
+ *
+ *  \hideinitializer
+ *
+ *  Use this instead of \c ISR() to declare interrupt service routines
+ *  that should run on the kernel stack. The vector saves R31 and the
+ *  task's stack pointer, switches to the kernel stack and passes the
+ *  actual routine to artx_call_isr(), which saves the remaining
+ *  call-used registers.
+ *
+ *  With #ARTX_ENABLE_MONITOR, the cycles spent in the routine are
+ *  reported separately by the monitor. With #ARTX_ENABLE_TRACE, the
+ *  entry and exit of the routine is recorded.
+ *
+ *  \param the_isr               The interrupt vector name.
+ */
+# define ARTX_ISR(the_isr)                                              \
+                                                                        \
+static void artx_isr_ ## the_isr(void) artxASMONLY;                     \
+                                                                        \
+ISR(the_isr, ISR_NAKED)                                                 \
 {                                                                       \
   asm volatile (                                                        \
                                                                         \
-    "sts   artx_REG, r31             \n\t" /* save R31               */ \
+    "sts   artx_isr_R31, r31         \n\t" /* save R31               */ \
                                                                         \
     "in    r31, __SP_L__             \n\t" /* save low byte of SP    */ \
-    "sts   artx_SPL, r31             \n\t"                              \
+    "sts   artx_isr_SP, r31          \n\t"                              \
     "in    r31, __SP_H__             \n\t" /* save high byte of SP   */ \
-    "sts   artx_SPH, r31             \n\t"                              \
+    "sts   artx_isr_SP + 1, r31      \n\t"                              \
                                                                         \
     "ldi   r31, lo8(__stack)         \n\t" /* switch to kernel stack */ \
     "out   __SP_L__, r31             \n\t"                              \
     "ldi   r31, hi8(__stack)         \n\t"                              \
     "out   __SP_H__, r31             \n\t"                              \
                                                                         \
+    "push  r30                       \n\t" /* save R30               */ \
+                                                                        \
+    "ldi   r30, lo8(gs(artx_isr_" #the_isr ")) \n\t" /* load routine */ \
+    "ldi   r31, hi8(gs(artx_isr_" #the_isr ")) \n\t"                    \
+                                                                        \
+    "%~jmp artx_call_isr             \n\t"                              \
+    : :                                                                 \
   );                                                                    \
+}                                                                       \
+                                                                        \
+artx_ISR_ROUTINE_(artx_isr_ ## the_isr, #the_isr)
+
+#elif ARTX_ENABLE_MONITOR || ARTX_ENABLE_TRACE
+
+# define ARTX_ISR(the_isr)                                              \
                                                                         \
-  artx_call_isr(&artx_isr_ ## the_isr);                                 \
+static void artx_isr_ ## the_isr(void);                                 \
+                                                                        \
+ISR(the_isr)                                                            \
+{                                                                       \
+  artx_isr_ ## the_isr();                                               \
 }                                                                       \
                                                                         \
-void artx_isr_ ## the_isr(void)
+artx_ISR_ROUTINE_(artx_isr_ ## the_isr, #the_isr)
 
-#else // !ARTX_ENABLE_MONITOR
+#else
 
 # define ARTX_ISR(the_isr)   ISR(the_isr)
 
-#endif // ARTX_ENABLE_MONITOR
+#endif // ARTX_ENABLE_ISR_STACK
 
 #endif
@@ -0,0 +1,170 @@
+#ifndef artx_LOG_H_
+#define artx_LOG_H_
+
+/*******************************************************************************
+*
+* ARTX binary logging
+*
+********************************************************************************
+*
+* ARTX - A realtime executive library for Atmel AVR microcontrollers
+*
+* Copyright (C) 2007-2015 Marcus Holland-Moritz.
+*
+* ARTX is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* ARTX is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with ARTX.  If not, see <http://www.gnu.org/licenses/>.
+*
+*******************************************************************************/
+
+/**
+ *  \file artx/log.h
+ *  \brief Binary logging
+ */
+
+#include <stdint.h>
+#include <avr/pgmspace.h>
+
+#include "artx/artx.h"
+#include "artx/handy.h"
+
+/**
+ *  Check log arguments
+ *
+ *  \internal
+ *
+ *  This routine is never called. It only makes the compiler check
+ *  the arguments passed to ARTX_LOG() against the format string.
+ */
+static artxUNUSED void artx_log_check(const char *fmt, ...)
+                                      __attribute__((format(printf, 1, 2)));
+static artxUNUSED void artx_log_check(const char *fmt artxUNUSED, ...)
+{
+}
+
+#if ARTX_ENABLE_LOG
+
+/**
+ *  Log protocol version
+ *
+ *  \internal
+ */
+#define artx_LOG_VERSION          1
+
+/**
+ *  Log message header
+ *
+ *  \internal
+ *
+ *  This header is sent directly after the log marker. It is
+ *  followed by \c size bytes of log records. Each record consists
+ *  of the flash address of the format string (2 bytes), the number
+ *  of argument bytes (1 byte) and the raw argument bytes.
+ */
+struct artx_log_header
+{
+  uint8_t  version;              //!< Protocol version
+  uint8_t  hdr_size;             //!< Size of this structure
+  uint8_t  size;                 //!< Number of record bytes following
+  uint8_t  lost;                 //!< Number of records lost since last message
+};
+
+extern uint8_t artx_log_buf[ARTX_LOG_SIZE];
+extern volatile uint8_t artx_log_head;
+extern volatile uint8_t artx_log_tail;
+extern uint8_t artx_log_lost;
+
+void artx_log_write(PGM_P fmt, const void *args, uint8_t size);
+void artx_log_transmit(void);
+
+/* count the arguments following the format string (at most 6) */
+#define artx_LOG_NARGS(...)       artx_LOG_NARGS_(__VA_ARGS__, 6, 5, 4, 3, 2, 1, 0, ~)
+#define artx_LOG_NARGS_(f, _1, _2, _3, _4, _5, _6, n, ...)  n
+
+#define artx_LOG_CAT(a, b)        artx_LOG_CAT_(a, b)
+#define artx_LOG_CAT_(a, b)       a ## b
+
+/* arguments are stored after the usual argument promotions */
+#define artx_LOG_T(x, n)          __typeof__((x) + 0) a ## n;
+
+#define artx_LOG_N(fmt, decl, ...)                                          \
+          do {                                                              \
+            struct { decl } artx_log_args_ = { __VA_ARGS__ };               \
+            artx_log_write(PSTR(fmt), &artx_log_args_,                      \
+                           sizeof(artx_log_args_));                         \
+          } while (0)
+
+#define artx_LOG_0(fmt)                                                     \
+          artx_log_write(PSTR(fmt), 0, 0)
+#define artx_LOG_1(fmt, a)                                                  \
+          artx_LOG_N(fmt, artx_LOG_T(a, 0), a)
+#define artx_LOG_2(fmt, a, b)                                               \
+          artx_LOG_N(fmt, artx_LOG_T(a, 0) artx_LOG_T(b, 1), a, b)
+#define artx_LOG_3(fmt, a, b, c)                                            \
+          artx_LOG_N(fmt, artx_LOG_T(a, 0) artx_LOG_T(b, 1)                 \
+                          artx_LOG_T(c, 2), a, b, c)
+#define artx_LOG_4(fmt, a, b, c, d)                                         \
+          artx_LOG_N(fmt, artx_LOG_T(a, 0) artx_LOG_T(b, 1)                 \
+                          artx_LOG_T(c, 2) artx_LOG_T(d, 3), a, b, c, d)
+#define artx_LOG_5(fmt, a, b, c, d, e)                                      \
+          artx_LOG_N(fmt, artx_LOG_T(a, 0) artx_LOG_T(b, 1)                 \
+                          artx_LOG_T(c, 2) artx_LOG_T(d, 3)                 \
+                          artx_LOG_T(e, 4), a, b, c, d, e)
+#define artx_LOG_6(fmt, a, b, c, d, e, f)                                   \
+          artx_LOG_N(fmt, artx_LOG_T(a, 0) artx_LOG_T(b, 1)                 \
+                          artx_LOG_T(c, 2) artx_LOG_T(d, 3)                 \
+                          artx_LOG_T(e, 4) artx_LOG_T(f, 5), a, b, c, d, e, f)
+
+/**
+ *  Log a message
+ *
+ *  \hideinitializer
+ *
+ *  Stores a log message in the log buffer. Instead of formatting
+ *  the message, only the address of the format string, which is
+ *  placed in flash, and the raw bytes of up to six arguments are
+ *  stored. This only takes a few dozen cycles, so it is safe to
+ *  use even in time critical routines and in interrupt service
+ *  routines. The idle task sends the stored messages via the serial
+ *  port and tools/artx-log turns them back into text using the
+ *  format strings from the application's ELF file.
+ *
+ *  The format string must be a string literal and supports the
+ *  conversions of the avr-libc printf() family. The arguments are
+ *  stored after the usual argument promotions, and the compiler
+ *  checks them against the format string. As only the arguments
+ *  themselves are stored, \c %s logs the address of the string
+ *  rather than its contents.
+ *
+ *  If the log buffer is full, the message is dropped and counted
+ *  as lost.
+ *
+ *  \code
+ *  ARTX_LOG("temp=%u", temp);
+ *  \endcode
+ */
+# define ARTX_LOG(...)                                                      \
+          do {                                                              \
+            if (0) artx_log_check(__VA_ARGS__);                             \
+            artx_LOG_CAT(artx_LOG_, artx_LOG_NARGS(__VA_ARGS__))(__VA_ARGS__); \
+          } while (0)
+
+#else /* !ARTX_ENABLE_LOG */
+
+# define ARTX_LOG(...)                                                      \
+          do {                                                              \
+            if (0) artx_log_check(__VA_ARGS__);                             \
+          } while (0)
+
+#endif /* ARTX_ENABLE_LOG */
+
+#endif
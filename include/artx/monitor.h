@@ -34,6 +34,7 @@
 #include <avr/pgmspace.h>
 
 #include "artx/artx.h"
+#include "artx/stack.h"
 
 #if ARTX_ENABLE_MONITOR
 
@@ -53,10 +54,21 @@
  *
  *  \internal
  *
- *  The version of the monitor protocol. To be used for future
- *  enhancements.
+ *  The version of the monitor protocol. Version 1 adds the
+ *  optional 'M' block holding the name of the current mode.
+ *  Version 2 adds the 'I' and 'K' blocks holding the cycles
+ *  spent in interrupt service routines and in the kernel.
+ *  Version 3 adds the optional 'P' block holding the program
+ *  counter samples. Version 4 adds the optional 'C' block holding
+ *  the interrupt disabled windows. Version 5 adds the optional 'H'
+ *  block holding the execution time histogram of the preceding task
+ *  or routine. Version 6 adds the optional 'J' block holding the
+ *  release latency statistics of the preceding task. Version 7
+ *  sends the monitoring info of tasks and routines as separate
+ *  #artx_monitor_info aggregate and adds the number of intervals
+ *  covered by the message to the header.
  */
-#define artx_MONITOR_VERSION      0
+#define artx_MONITOR_VERSION      7
 
 /**
  *  Monitoring message header
@@ -78,32 +90,103 @@ struct artx_monitor_header
   uint16_t tick_prescaler;       //!< Counter prescaler used for tick
   uint16_t monitor_interval;     //!< Monitoring interval in ticks
   uint32_t clock_frequency;      //!< System clock frequency
+  uint8_t  cyc_size;             //!< Size of cycle accounting info
+  uint8_t  info_size;            //!< Size of task/routine monitoring info
+  uint8_t  intervals;            //!< Number of intervals covered by message
 };
 
 /**
- *  Monitoring state
+ *  Cycle accounting info
  *
  *  \internal
  *
- *  Indicates the monitoring state of each task and routine.
+ *  This aggregate holds the cycles spent in a task, routine,
+ *  interrupt service routine or in the kernel during one
+ *  monitoring interval.
  *
- *  At the end of the monitoring interval, the state of all tasks
- *  and routines that have been run at least once is changed from
- *  #artx_MS_COLLECT to #artx_MS_READY in artx_yield().
- *  This will prevent further updates and ensure a consistent set
- *  of data when the information is transmitted. After it has been
- *  transmitted by artx_monitor_transmit(), the state will be
- *  changed to #artx_MS_SENT. At the end of the next monitoring
- *  interval, the state of all routines that are in #artx_MS_SENT
- *  state is set back to #artx_MS_COLLECT.
+ *  All monitoring information is collected in one of two banks.
+ *  The kernel only ever updates the bank selected by
+ *  artx_monitor_control::bank. At the end of a monitoring interval,
+ *  the tick merely switches to the other bank, and the bank holding
+ *  the info of the last interval is transmitted and cleared by
+ *  artx_monitor_transmit() in the idle task. If the idle task didn't
+ *  manage to transmit the last interval in time, the tick keeps
+ *  collecting into the same bank for another interval.
  */
-enum artx_monitor_state
+struct artx_monitor_cycles
 {
-  artx_MS_COLLECT,               //!< Collecting monitoring information
-  artx_MS_READY,                 //!< Information ready to be transmitted
-  artx_MS_SENT                   //!< Information has been sent
+  uint32_t total_cycles;         //!< Accumulated cycles of run_counter runs
+  uint32_t peak_cycles;          //!< Peak cycles of a single run
+  uint16_t run_counter;          //!< How many times the code was run
+};
+
+/**
+ *  Transmitted monitoring info
+ *
+ *  \internal
+ *
+ *  This aggregate is composed from the banked monitoring info of
+ *  a task or routine when it is transmitted. Tasks and routines
+ *  that have not completed a single run during an interval are not
+ *  transmitted, their intervals are added to the next transmission.
+ */
+struct artx_monitor_info
+{
+  uint32_t total_cycles;         //!< Accumulated cycles of run_counter runs
+  uint32_t peak_cycles;          //!< Peak cycles of a single run
+  uint16_t run_counter;          //!< How many times the task/routine was run
+  uint8_t intervals;             //!< Number of intervals covered
+  uint16_t stack_size;           //!< Stack size of task (bytes)
+  uint16_t stack_usage;          //!< Used stack size of task (bytes)
 };
 
+#if ARTX_ENABLE_STATS
+
+/**
+ *  Task statistics
+ *
+ *  This structure holds a snapshot of the monitoring information
+ *  of a task from the last complete monitoring interval. Cycles
+ *  are in units of the timer used as the tick source.
+ *
+ *  \see ARTX_stats_get_task()
+ */
+struct ARTX_task_stats
+{
+  uint32_t total_cycles;         //!< Cycles spent in the task
+  uint32_t peak_cycles;          //!< Peak cycles of a single run
+  uint16_t run_counter;          //!< How many times the task was run
+  uint16_t stack_size;           //!< Stack size of task (bytes)
+  uint16_t stack_usage;          //!< Maximum stack usage of task (bytes)
+  uint8_t load;                  //!< Share of CPU time spent in the task (percent)
+};
+
+#endif
+
+#if ARTX_ENABLE_LATENCY
+
+/**
+ *  Release latency statistics
+ *
+ *  \internal
+ *
+ *  This aggregate holds the start latencies and response times of
+ *  all runs of a task that completed during a monitoring interval.
+ *  All values are in units of the timer used as the tick source.
+ */
+struct artx_monitor_latency
+{
+  uint32_t start_min;            //!< Minimum start latency
+  uint32_t start_max;            //!< Maximum start latency
+  uint32_t start_total;          //!< Accumulated start latency of count runs
+  uint32_t resp_min;             //!< Minimum response time
+  uint32_t resp_max;             //!< Maximum response time
+  uint32_t resp_total;           //!< Accumulated response time of count runs
+  uint16_t count;                //!< Number of completed runs
+};
+
+#endif
+
 /**
  *  Task monitoring info
  *
@@ -114,18 +197,24 @@ enum artx_monitor_state
  */
 struct artx_monitor_task
 {
-  uint32_t current_cycles;       //!< How many cycles have been spent
-  uint32_t peak_cycles;          //!< Peak of current_cycles
-  uint32_t total_cycles;         //!< Accumulated cycles of run_counter runs
-  uint16_t run_counter;          //!< How many times the task was scheduled
-  uint8_t intervals;             //!< Number of intervals used for monitoring
+  uint32_t current_cycles;       //!< Cycles spent in current run
+  struct artx_monitor_cycles bank[2]; //!< Cycles of completed runs
+  uint8_t intervals;             //!< Intervals carried over without a run
   uint16_t stack_size;           //!< Stack size of task (bytes)
   uint16_t stack_usage;          //!< Used stack size of task (bytes)
-
-  // The following data will not be sent directly
   PGM_P name;                    //!< ASCII name of task/routine
-  enum artx_monitor_state state; //!< Monitoring state
-  uint8_t *stack_ptr;            //!< Pointer to user stack
+  uint8_t walk;                  //!< Last task list walk visiting the task
+  struct artx_stack_mark stack;  //!< Watermark of user stack
+#if ARTX_ENABLE_HISTOGRAM
+  uint16_t hist[2][ARTX_HISTOGRAM_BINS]; //!< Histogram of current_cycles
+#endif
+#if ARTX_ENABLE_LATENCY
+  uint32_t start_latency;        //!< Start latency of current run
+  struct artx_monitor_latency lat[2]; //!< Release latency statistics
+#endif
+#if ARTX_ENABLE_STATS
+  struct ARTX_task_stats stats;  //!< Snapshot of last complete interval
+#endif
 };
 
 /**
@@ -138,18 +227,97 @@ struct artx_monitor_task
  */
 struct artx_monitor_rout
 {
-  uint32_t current_cycles;       //!< how many cycles have been spent
-  uint32_t peak_cycles;          //!< peak of current_cycles
-  uint32_t total_cycles;         //!< accumulated cycles of run_counter runs
-  uint16_t run_counter;          //!< how many times the routine was scheduled
-  uint8_t intervals;             //!< number of intervals used for monitoring
+  uint32_t current_cycles;       //!< cycles spent in current run
+  struct artx_monitor_cycles bank[2]; //!< cycles of completed runs
+  uint8_t intervals;             //!< intervals carried over without a run
+  PGM_P name;                    //!< ASCII name of task/routine
+#if ARTX_ENABLE_HISTOGRAM
+  uint16_t hist[2][ARTX_HISTOGRAM_BINS]; //!< histogram of current_cycles
+#endif
+};
+
+/**
+ *  Cycle accounting
+ *
+ *  \internal
+ *
+ *  This aggregate contains all monitoring information for an
+ *  interrupt service routine or the kernel. Unlike tasks, these
+ *  are transmitted at the end of every monitoring interval.
+ */
+struct artx_monitor_account
+{
+  struct artx_monitor_cycles bank[2];  //!< Info of current and last interval
 
   // The following data will not be sent directly
-  PGM_P name;                    //!< ASCII name of task/routine
-  enum artx_monitor_state state; //!< monitoring state
-  uint8_t running;               //!< currently running routine of task
+  PGM_P name;                          //!< ASCII name of routine
+  struct artx_monitor_account *next;   //!< Next routine in list
+};
+
+#if ARTX_ENABLE_PROFILE
+
+/**
+ *  Program counter sample
+ *
+ *  \internal
+ *
+ *  A single entry of the program counter histogram. The program
+ *  counter is the (word) address where a task was interrupted by
+ *  the tick.
+ */
+struct artx_monitor_sample
+{
+  uint16_t pc;                   //!< Program counter
+  uint16_t count;                //!< Number of samples
+};
+
+/**
+ *  Program counter histogram
+ *
+ *  \internal
+ *
+ *  This aggregate holds the program counter samples taken during
+ *  one monitoring interval. Samples that do not fit into the hash
+ *  table are only counted in \c other.
+ */
+struct artx_monitor_profile
+{
+  struct artx_monitor_sample sample[ARTX_PROFILE_SIZE];  //!< Hash table
+  uint16_t other;                                        //!< Samples dropped
+};
+
+#endif
+
+#if ARTX_ENABLE_CLI_PROFILE
+
+/**
+ *  Number of interrupt disabled window histogram bins
+ *
+ *  \internal
+ *
+ *  Bin 0 counts windows shorter than 16 timer units, each further
+ *  bin doubles the limit, and the last bin counts all longer windows.
+ */
+#define artx_CLI_BINS             8
+
+/**
+ *  Interrupt disabled window statistics
+ *
+ *  \internal
+ *
+ *  This aggregate holds the statistics of all interrupt disabled
+ *  windows started at the same site. Durations are in units of the
+ *  timer used as the tick source.
+ */
+struct artx_monitor_cli
+{
+  uint16_t site;                 //!< Address where window started
+  uint16_t max;                  //!< Longest window
+  uint16_t bins[artx_CLI_BINS];  //!< Histogram of window durations
 };
 
+#endif
+
 /**
  *  Declare task or routine name
  *
@@ -173,9 +341,8 @@ struct artx_monitor_rout
 #define artx_MONITOR_TASK_INIT_(member, task)                              \
               .member = { .stack_size = sizeof(task ## _stack)             \
                                       - artx_STACK_OVERHEAD,               \
-                          .stack_ptr = &task ## _stack[artx_CONTEXT_SIZE], \
-                          .intervals = 1,                                  \
-                          .state = artx_MS_COLLECT,                        \
+                          .stack = { .base = &task ## _stack               \
+                                                 [artx_CONTEXT_SIZE] },    \
                           .name = &task ## _name[0] },
 
 /**
@@ -187,9 +354,7 @@ struct artx_monitor_rout
  *  This macro initializes the monitoring info for a routine.
  */
 #define artx_MONITOR_ROUT_INIT_(member, rout)                              \
-              .member = { .intervals = 1,                                  \
-                          .state = artx_MS_COLLECT,                        \
-                          .name = &rout ## _name[0] },
+              .member = { .name = &rout ## _name[0] },
 
 /**
  *  Monitor controlling
@@ -206,15 +371,188 @@ struct artx_monitor_control
   uint8_t transmit_request;      //!< The available data should be transmitted
   uint16_t interval;             //!< Monitoring interval in ticks
   uint16_t schedule;             //!< Schedule for monitoring interval
+  uint8_t bank;                  //!< Bank currently collecting
+  uint8_t intervals[2];          //!< Intervals collected in each bank
 };
 
 extern struct artx_monitor_control artx_monitor_ctl;
+extern struct artx_monitor_account artx_monitor_kernel;
+extern struct artx_monitor_account *artx_monitor_isr_list;
+#if ARTX_ENABLE_PROFILE
+extern struct artx_monitor_profile artx_monitor_prof[2];
+#endif
+#if ARTX_ENABLE_CLI_PROFILE
+extern struct artx_monitor_cli artx_monitor_cli[ARTX_CLI_SITES];
+extern uint16_t artx_monitor_cli_other;
+#endif
+
+struct artx_tcb;
 
 void artx_monitor_transmit(void);
+struct artx_tcb *artx_task_walk(struct artx_tcb *tcb);
 void artx_monitor_task_init(struct artx_monitor_task *mon);
+void artx_monitor_run_isr(struct artx_monitor_account *acc, void (*isr)(void));
 void ARTX_monitor_set_interval(uint16_t interval);
 
-#else /* !ARTX_ENABLE_MONITOR */
+#if ARTX_ENABLE_STATS
+
+struct artx_tcb;
+
+extern uint8_t artx_stats_cpu_load;
+
+void ARTX_stats_get_task(const struct artx_tcb *tcb, struct ARTX_task_stats *stats);
+
+/**
+ *  Get CPU load
+ *
+ *  This routine returns the share of CPU time that was not spent
+ *  in the idle task during the last complete monitoring interval,
+ *  i.e. the time spent in user tasks, interrupt service routines
+ *  and the kernel. Use ARTX_stats_get_age() to check if the value
+ *  is still up to date.
+ *
+ *  \returns CPU load in percent.
+ */
+
+static inline uint8_t ARTX_stats_get_cpu_load(void)
+{
+  return artx_stats_cpu_load;
+}
+
+/**
+ *  Get idle percentage
+ *
+ *  This routine returns the share of CPU time that was spent in
+ *  the idle task during the last complete monitoring interval.
+ *
+ *  \returns Idle time in percent.
+ */
+
+static inline uint8_t ARTX_stats_get_idle(void)
+{
+  return 100 - artx_stats_cpu_load;
+}
+
+/**
+ *  Get age of statistics
+ *
+ *  This routine returns the number of complete monitoring intervals
+ *  that are not yet reflected in the statistics. The statistics are
+ *  updated by the idle task, so they are not updated at all while the
+ *  system is overloaded. An age of zero means the statistics refer to
+ *  the last complete interval, and an age of one is normal right after
+ *  an interval has completed. Anything above that means that the idle
+ *  task didn't get to run and the CPU load is higher than reported.
+ *  The age saturates at 255.
+ *
+ *  Calls to this routine must be locked.
+ *
+ *  \returns Age of the statistics in monitoring intervals.
+ */
+
+static inline uint8_t ARTX_stats_get_age(void)
+{
+  uint16_t age = artx_monitor_ctl.intervals[0] + artx_monitor_ctl.intervals[1];
+
+  return age > UINT8_MAX ? UINT8_MAX : age;
+}
+
+#endif
+
+#elif ARTX_ENABLE_SAMPLING
+
+# define artx_MONITOR_EXTRA_STACK  0
+
+/**
+ *  Sampling protocol version
+ *
+ *  \internal
+ *
+ *  The version of the sampling monitor protocol.
+ */
+#define artx_SAMPLING_VERSION     0
+
+/**
+ *  Sampling message header
+ *
+ *  \internal
+ *
+ *  This header is sent directly after the message marker of
+ *  the sampling monitor.
+ */
+struct artx_sampling_header
+{
+  uint8_t  version;              //!< Protocol version
+  uint8_t  hdr_size;             //!< Size of this structure
+  uint16_t interval;             //!< Samples per message
+};
+
+/**
+ *  Task sampling info
+ *
+ *  \internal
+ *
+ *  This aggregate contains the sampling information for a single
+ *  task. With #ARTX_USE_MULTI_ROUT, the task also keeps track of
+ *  the position of the routine it is currently running in its list
+ *  of routines, or zero if it isn't running a routine.
+ */
+struct artx_sampling_task
+{
+  uint16_t samples;              //!< Samples taken while task was running
+  PGM_P name;                    //!< ASCII name of task
+  uint8_t walk;                  //!< Last task list walk visiting the task
+#if ARTX_USE_MULTI_ROUT
+  uint8_t running;               //!< Index of running routine (1-based)
+#endif
+};
+
+/**
+ *  Routine sampling info
+ *
+ *  \internal
+ *
+ *  This aggregate contains the sampling information for a single
+ *  routine.
+ */
+struct artx_sampling_rout
+{
+  uint16_t samples;              //!< Samples taken while routine was running
+  PGM_P name;                    //!< ASCII name of routine
+};
+
+/**
+ *  Sampling control
+ *
+ *  \internal
+ *
+ *  This aggregate is used by the sampling interrupt to signal the
+ *  idle task when to transmit the sample counts.
+ */
+struct artx_sampling_control
+{
+  uint8_t transmit_request;      //!< The sample counts should be transmitted
+  uint16_t countdown;            //!< Samples left until next transmission
+  uint16_t seed;                 //!< State of the sample point generator
+};
+
+# define artx_NAME_DECL(the_name)                                          \
+              static const char the_name ## _name[] PROGMEM = (#the_name);
+
+# define artx_MONITOR_TASK_INIT_(member, task)                             \
+              .member = { .name = &task ## _name[0] },
+
+# define artx_MONITOR_ROUT_INIT_(member, rout)                             \
+              .member = { .name = &rout ## _name[0] },
+
+extern struct artx_sampling_control artx_sampling_ctl;
+
+struct artx_tcb;
+
+void artx_sampling_transmit(void);
+struct artx_tcb *artx_task_walk(struct artx_tcb *tcb);
+
+#else /* !ARTX_ENABLE_MONITOR && !ARTX_ENABLE_SAMPLING */
 
 # define artx_MONITOR_EXTRA_STACK  0
 
@@ -0,0 +1,77 @@
+#ifndef artx_STACK_H_
+#define artx_STACK_H_
+
+/*******************************************************************************
+*
+* ARTX stack usage checking
+*
+********************************************************************************
+*
+* ARTX - A realtime executive library for Atmel AVR microcontrollers
+*
+* Copyright (C) 2007-2015 Marcus Holland-Moritz.
+*
+* ARTX is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* ARTX is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with ARTX.  If not, see <http://www.gnu.org/licenses/>.
+*
+*******************************************************************************/
+
+/**
+ *  \file artx/stack.h
+ *  \brief Stack usage checking
+ */
+
+#include <stdint.h>
+
+#include "artx/artx.h"
+
+#if ARTX_ENABLE_MONITOR || ARTX_ENABLE_STACK_CHECK
+
+/**
+ *  Stack watermark
+ *
+ *  \internal
+ *
+ *  The stack of a task is filled with sentinel bytes when the task
+ *  is set up. As the stack grows downwards, the bytes at the bottom
+ *  of the stack that still hold the sentinel have never been used.
+ *  Their number, the watermark, can only ever decrease.
+ *
+ *  Each scan looks at no more than #ARTX_STACK_SCAN_BUDGET bytes,
+ *  starting right below the watermark and resuming where the last
+ *  scan stopped, so the cost of a scan doesn't depend on the size of
+ *  the stack. Once the bottom of the stack is reached, the next scan
+ *  starts again below the (possibly lowered) watermark.
+ */
+struct artx_stack_mark
+{
+  uint8_t *base;                 //!< Bottom of the stack
+  uint16_t mark;                 //!< Number of bytes that have never been used
+  uint16_t scan;                 //!< Position of the next scan, 0 for a new pass
+};
+
+void artx_stack_init(struct artx_stack_mark *stk, uint16_t size);
+uint16_t artx_stack_scan(struct artx_stack_mark *stk);
+
+#endif
+
+#if ARTX_ENABLE_STACK_CHECK
+
+struct artx_tcb;
+
+uint16_t ARTX_stack_get_free(struct artx_tcb *tcb);
+struct artx_tcb *ARTX_stack_check(void);
+
+#endif
+
+#endif
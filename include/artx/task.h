@@ -36,6 +36,7 @@
 #include "artx/artx.h"
 #include "artx/handy.h"
 #include "artx/monitor.h"
+#include "artx/stack.h"
 
 #if ARTX_USE_MULTI_ROUT
 
@@ -77,11 +78,114 @@ struct artx_rcb
 #endif
 #if ARTX_ENABLE_MONITOR
   struct artx_monitor_rout mon;  //!< Routine monitoring info
+#elif ARTX_ENABLE_SAMPLING
+  struct artx_sampling_rout mon; //!< Routine sampling info
 #endif
 };
 
 #endif /* ARTX_USE_MULTI_ROUT */
 
+#if ARTX_USE_TASK_SUSPEND
+
+/**
+ *  Task State
+ *
+ *  The run-time state of a task when ARTX is built with
+ *  \c ARTX_USE_TASK_SUSPEND.
+ */
+enum ARTX_task_state
+{
+  ARTX_TS_ACTIVE,                //!< The task is scheduled
+  ARTX_TS_SUSPENDED,             //!< The task is not scheduled
+  ARTX_TS_INACTIVE               //!< The task is not part of the current mode
+};
+
+#endif /* ARTX_USE_TASK_SUSPEND */
+
+/**
+ *  Schedule type
+ *
+ *  \internal
+ *
+ *  Type of a task's schedule and interval. With #ARTX_USE_ABS_RELEASE,
+ *  the schedule holds the absolute tick of the next release. As the
+ *  tick count wraps around, absolute schedules are unsigned and must
+ *  only be compared using their difference.
+ */
+#if ARTX_USE_ABS_RELEASE
+typedef uint32_t artx_sched_type;
+#elif ARTX_USE_SHORT_SCHEDULE
+typedef int8_t artx_sched_type;
+# define artx_SCHED_MIN          INT8_MIN
+#else
+typedef int16_t artx_sched_type;
+# define artx_SCHED_MIN          INT16_MIN
+#endif
+
+/**
+ *  Schedule difference type
+ *
+ *  \internal
+ *
+ *  Signed type of the difference of two schedules, which is also
+ *  used for schedules relative to the current tick.
+ */
+#if ARTX_USE_ABS_RELEASE
+typedef int32_t artx_sched_diff_type;
+#else
+typedef artx_sched_type artx_sched_diff_type;
+#endif
+
+/**
+ *  Interval type
+ *
+ *  Type used to pass scheduling intervals and offsets to the kernel.
+ */
+#if ARTX_USE_ABS_RELEASE
+typedef uint32_t ARTX_interval_type;
+#elif ARTX_USE_SHORT_SCHEDULE
+typedef uint8_t ARTX_interval_type;
+#else
+typedef uint16_t ARTX_interval_type;
+#endif
+
+#if ARTX_USE_ROM_TCB
+
+/**
+ *  Constant Task Data
+ *
+ *  \internal
+ *
+ *  The part of a task's information that lives in flash when
+ *  ARTX is built with #ARTX_USE_ROM_TCB.
+ */
+struct artx_tcb_rom
+{
+  void (*rout)(void);            //!< Routine address
+  artx_sched_type interval;      //!< Multiple of timebase
+  uint8_t priority;              //!< 0 - highest / 255 - lowest
+};
+
+#endif /* ARTX_USE_ROM_TCB */
+
+#if ARTX_ENABLE_SPORADIC
+
+/**
+ *  Sporadic Server Replenishment
+ *
+ *  \internal
+ *
+ *  A chunk of capacity used by a sporadic server that will be
+ *  given back to the server at a later tick.
+ */
+struct artx_replenishment
+{
+  uint32_t at;                   //!< Tick count of replenishment
+  uint32_t amount;               //!< Capacity to replenish
+};
+
+#endif /* ARTX_ENABLE_SPORADIC */
+
 /**
  *  Task Control Block
  *
@@ -90,7 +194,9 @@ struct artx_rcb
  *  A task control block (TCB) holds all per-task information, like
  *  scheduling information or where the tasks stack is located.
  *
- *  A plain TCB uses 11 bytes of RAM per task. Again, enabling
+ *  A plain TCB uses 11 bytes of RAM per task, or 15 bytes with
+ *  #ARTX_USE_ABS_RELEASE. With #ARTX_USE_ROM_TCB, it only uses 8
+ *  bytes, or 7 bytes with #ARTX_USE_SHORT_SCHEDULE. Again, enabling
  *  monitoring support will increase that size. Keep in mind that
  *  the overhead for a task is not only its TCB. Each task has its
  *  own stack frame, and the overhead for storing each task's context
@@ -103,19 +209,153 @@ struct artx_tcb
   volatile uint16_t sp_cxt;      //!< Context stack pointer (must be second!)
 #endif
   struct artx_tcb *next;         //!< Pointer to next task
-#if ARTX_USE_MULTI_ROUT
+#if ARTX_USE_ROM_TCB
+  const struct artx_tcb_rom *rom;  //!< Constant task data in flash
+#elif ARTX_USE_MULTI_ROUT
   struct artx_rcb *rout;         //!< Pointer to routines
 #else
   void (*rout)(void);            //!< Routine address
 #endif
-  int16_t schedule;              //!< When the task is about to be scheduled
-  int16_t interval;              //!< Multiple of timebase
+  artx_sched_type schedule;      //!< When the task is about to be scheduled
+#if !ARTX_USE_ROM_TCB
+  artx_sched_type interval;      //!< Multiple of timebase
   uint8_t priority;              //!< 0 - highest / 255 - lowest
+#endif
 #if ARTX_ENABLE_MONITOR
   struct artx_monitor_task mon;  //!< Task monitoring info
+#elif ARTX_ENABLE_SAMPLING
+  struct artx_sampling_task mon; //!< Task sampling info
+#endif
+#if ARTX_ENABLE_STACK_CHECK && !ARTX_ENABLE_MONITOR
+  struct artx_stack_mark stack;  //!< Stack watermark
+#endif
+#if ARTX_SCHED_EDF
+  struct artx_tcb *edf_next;     //!< Pointer to next task in EDF ready list
+#endif
+#if ARTX_USE_TASK_SUSPEND
+  enum ARTX_task_state state;    //!< Task state
+  uint32_t suspended_at;         //!< Tick count at time of suspension
+#endif
+#if ARTX_ENABLE_BUDGET
+  uint32_t budget;               //!< Execution budget per release (0 = none)
+  uint32_t budget_used;          //!< Budget used in current release
+  uint16_t overruns;             //!< Number of budget overruns
+#endif
+#if ARTX_ENABLE_SPORADIC
+  uint8_t sporadic;              //!< Nonzero if task is a sporadic server
+  uint8_t pending;               //!< Number of pending requests
+  uint8_t repl_head;             //!< Index of next replenishment
+  uint8_t repl_count;            //!< Number of pending replenishments
+  uint32_t activated_at;         //!< Tick count of current activation
+  uint32_t consumed;             //!< Capacity used since activation
+  struct artx_replenishment repl[ARTX_SPORADIC_REPLENISHMENTS]; //!< Pending replenishments
 #endif
 };
 
+#if ARTX_SCHED_TABLE
+
+/**
+ *  Schedule table task mask
+ *
+ *  \internal
+ *  \hideinitializer
+ *
+ *  A type wide enough to hold one bit for each of the tasks
+ *  that can be released by the static schedule table.
+ */
+#if ARTX_SCHED_TABLE_TASKS <= 8
+typedef uint8_t artx_tt_mask_type;
+#elif ARTX_SCHED_TABLE_TASKS <= 16
+typedef uint16_t artx_tt_mask_type;
+#else
+typedef uint32_t artx_tt_mask_type;
+#endif
+
+/**
+ *  Schedule table entry
+ *
+ *  \internal
+ *
+ *  Each entry of the static schedule table describes a single tick
+ *  at which tasks are released. Bit \e n of the mask corresponds to
+ *  the \e n-th element of #artx_tt_tasks. The last entry of the table
+ *  is followed by a terminating entry with a delay of zero, after
+ *  which processing continues at entry #artx_tt_loop.
+ */
+struct artx_tt_entry
+{
+  uint16_t delay;                //!< Ticks until the next entry
+  artx_tt_mask_type mask;        //!< Tasks released at this tick
+};
+
+/**
+ *  Schedule table
+ *
+ *  \internal
+ *
+ *  The static schedule table in flash, generated by tools/artx-ttgen.
+ */
+extern const struct artx_tt_entry artx_tt_table[];
+
+/**
+ *  Schedule table tasks
+ *
+ *  \internal
+ *
+ *  The tasks referenced by the static schedule table, in flash,
+ *  generated by tools/artx-ttgen.
+ */
+extern struct artx_tcb * const artx_tt_tasks[];
+
+/**
+ *  Schedule table loop entry
+ *
+ *  \internal
+ *
+ *  Index of the first entry of the part of #artx_tt_table that is
+ *  repeated every hyperperiod, in flash, generated by tools/artx-ttgen.
+ *  The entries before it delay the first release of tasks with an
+ *  offset larger than their interval and are only processed once.
+ */
+extern const uint16_t artx_tt_loop;
+
+#endif // ARTX_SCHED_TABLE
+
+#if ARTX_ENABLE_MODES
+
+/**
+ *  Mode task entry
+ *
+ *  \internal
+ *
+ *  Describes a single task that is active in an operating mode.
+ *  Use #ARTX_MODE_TASK to initialize these entries.
+ */
+struct artx_mode_task
+{
+  struct artx_tcb *tcb;          //!< Pointer to the task control block
+  artx_sched_type interval;      //!< Interval of the task in this mode
+  artx_sched_type offset;        //!< Release offset after mode switch
+};
+
+/**
+ *  Operating mode
+ *
+ *  An operating mode holds the set of tasks that are active while
+ *  the mode is selected. Modes are stored in flash and are declared
+ *  using #ARTX_MODE.
+ */
+struct artx_mode
+{
+  const struct artx_mode_task *tasks;  //!< Active tasks (in flash)
+  uint8_t count;                       //!< Number of active tasks
+#if ARTX_ENABLE_MONITOR
+  PGM_P name;                          //!< ASCII name of mode
+#endif
+};
+
+#endif // ARTX_ENABLE_MODES
+
 #if ARTX_ENABLE_TICK_SYNC
 /**
  *  Tick synchronization status
@@ -172,6 +412,24 @@ struct ARTX_timeval
 # define artx_SP_CXT_INIT_(task)
 #endif
 
+/**
+ *  Stack Watermark Initializer
+ *
+ *  \internal
+ *  \hideinitializer
+ *
+ *  With #ARTX_ENABLE_STACK_CHECK, this macro holds the initializer
+ *  for the bottom of the task's stack. With #ARTX_ENABLE_MONITOR,
+ *  this is part of the monitoring info.
+ *
+ *  \param task                  Task name.
+ */
+#if ARTX_ENABLE_STACK_CHECK && !ARTX_ENABLE_MONITOR
+# define artx_STACK_CHECK_INIT_(task) .stack = { .base = &task ## _stack[0] },
+#else
+# define artx_STACK_CHECK_INIT_(task)
+#endif
+
 /**
  *  Routine State Initializer
  *
@@ -191,9 +449,10 @@ struct ARTX_timeval
  *
  *  This defines the amount of bytes required on the stack to save
  *  the full context of a single task. The context consists of all
- *  32 general purpose registers plus the status register.
+ *  32 general purpose registers plus the status register, minus the
+ *  registers reserved using #ARTX_FIXED_REGS.
  */
-#define artx_CONTEXT_SIZE      (32 + 1)
+#define artx_CONTEXT_SIZE      (32 + 1 - ARTX_FIXED_REGS)
 
 /**
  *  Extra stack size required for each task
@@ -204,7 +463,8 @@ struct ARTX_timeval
  *  That's two bytes for the return address of the routine that's
  *  being run in the task plus two bytes for the return address
  *  of an interrupt that may occur when the task is being run.
- *
+ *  With #ARTX_ENABLE_ISR_STACK, this is also all that interrupt
+ *  service routines declared using ARTX_ISR() use on the task stack.
  */
 #define artx_TASK_EXTRA_STACK   (2 + 2)
 
@@ -228,7 +488,7 @@ struct ARTX_timeval
  *
  *  The total number bytes allocated on the stack for each task
  *  on top of the user defined stack size. Without monitoring
- *  support, this is currently 37 bytes.
+ *  support and reserved registers, this is currently 37 bytes.
  */
 #define artx_STACK_OVERHEAD  (artx_CONTEXT_SIZE + artx_EXTRA_STACK)
 
@@ -261,6 +521,29 @@ struct ARTX_timeval
  */
 #define artx_PRIO_IDLE          255
 
+/**
+ *  Register Task for Automatic Initialization
+ *
+ *  \internal
+ *  \hideinitializer
+ *
+ *  This is appended to the definition of the task's TCB, as the
+ *  init routine cannot refer to the TCB before it has been defined.
+ *  The routine is declared once more to take the semicolon that
+ *  follows the task declaration.
+ */
+#if ARTX_USE_AUTO_INIT
+# define artx_AUTO_INIT_TASK_(task)                                         \
+        ;                                                                  \
+        static artxINITSECTION(7) void task ## _auto_init(void)            \
+        {                                                                  \
+          ARTX_task_init(&task);                                           \
+        }                                                                  \
+        static artxINITSECTION(7) void task ## _auto_init(void)
+#else
+# define artx_AUTO_INIT_TASK_(task)
+#endif
+
 /**
  *  Allocate Task
  *
@@ -284,18 +567,20 @@ struct ARTX_timeval
  *                               of the tick interval.
  */
 #define artx_ALLOC_TASK(task, prio, ival, stack_size, offset)              \
-        ARTX_STATIC_ASSERT((int16_t) (ival) >= 0);                         \
+        ARTX_STATIC_ASSERT((artx_sched_diff_type) (ival) >= 0);            \
+        ARTX_STATIC_ASSERT((artx_sched_diff_type) (offset) >= 0);          \
         artx_NAME_DECL(task)                                               \
         static uint8_t task ## _stack[stack_size + artx_STACK_OVERHEAD];   \
         static struct artx_tcb task = {                                    \
           artx_MONITOR_TASK_INIT_(mon, task)                               \
           artx_SP_CXT_INIT_(task)                                          \
+          artx_STACK_CHECK_INIT_(task)                                     \
           .interval = ival,                                                \
           .priority = prio,                                                \
           .schedule = offset,                                              \
           .sp = (uint16_t) &task ## _stack[stack_size                      \
                                              + artx_STACK_OVERHEAD - 1]    \
-        }
+        } artx_AUTO_INIT_TASK_(task)
 
 /**
  *  Allocate User Task with Scheduling Offset
@@ -305,7 +590,8 @@ struct ARTX_timeval
  *  This macro will allocate all resources required for a new
  *  user task. It will preinitialize the task's TCB and allocate
  *  the task's stack. But don't forget to call ARTX_task_init()
- *  to fully initialize the task.
+ *  to fully initialize the task, unless you're using
+ *  #ARTX_USE_AUTO_INIT.
  *
  *  There can only be one task per priority, so don't try to set
  *  up multiple tasks running at the same priority. If you want
@@ -331,9 +617,14 @@ struct ARTX_timeval
  *  could be running at a certain offset relative to each other so they
  *  wouldn't interfere with each other. It is also possible to just use
  *  the offset to define a startup delay for a task.
+ *
+ *  With many tasks, picking good offsets by hand gets tedious. The
+ *  tools/artx-offsets script reads the task declarations from a source
+ *  file and assigns offsets that minimize the worst-case load per tick,
+ *  optionally weighted by the measured cost of each task.
  */
 #define ARTX_TASK_OFFS(task, prio, ival, stack_size, offset)               \
-          ARTX_STATIC_ASSERT((int16_t) (ival) > 0);                        \
+          ARTX_STATIC_ASSERT((artx_sched_diff_type) (ival) > 0);           \
           ARTX_STATIC_ASSERT((prio) >= 0 && (prio) <= ARTX_PRIO_USER_MAX); \
           artx_ALLOC_TASK(task, (prio) + artx_PRIO_USER_OFFSET, ival,      \
                           stack_size, offset + 1)
@@ -346,7 +637,8 @@ struct ARTX_timeval
  *  This macro will allocate all resources required for a new
  *  user task. It will preinitialize the task's TCB and allocate
  *  the task's stack. But don't forget to call ARTX_task_init()
- *  to fully initialize the task.
+ *  to fully initialize the task, unless you're using
+ *  #ARTX_USE_AUTO_INIT.
  *
  *  There can only be one task per priority, so don't try to set
  *  up multiple tasks running at the same priority. If you want
@@ -375,7 +667,8 @@ struct ARTX_timeval
  *  This macro will allocate all resources required for the idle
  *  task. It will preinitialize the task's TCB and allocate
  *  the task's stack. But don't forget to call ARTX_task_init()
- *  to fully initialize the task.
+ *  to fully initialize the task, unless you're using
+ *  #ARTX_USE_AUTO_INIT.
  *
  *  There can only be one idle task, so don't try to set up
  *  multiple idle tasks. If you want multiple routines to run
@@ -390,6 +683,115 @@ struct ARTX_timeval
 #define ARTX_IDLE_TASK(task, stack_size)                                   \
           artx_ALLOC_TASK(task, artx_PRIO_IDLE, 0, stack_size, 0)
 
+#if ARTX_USE_ROM_TCB
+
+/**
+ *  Allocate Task with Constant Data in Flash
+ *
+ *  \internal
+ *  \hideinitializer
+ *
+ *  Same as #artx_ALLOC_TASK, but the routine, interval and priority
+ *  are placed in flash.
+ */
+#define artx_ALLOC_ROM_TASK(task, prio, ival, stack_size, offset, routine) \
+        ARTX_STATIC_ASSERT((artx_sched_diff_type) (ival) >= 0);            \
+        ARTX_STATIC_ASSERT((artx_sched_diff_type) (offset) >= 0);          \
+        static void routine(void);                                         \
+        artx_NAME_DECL(task)                                               \
+        static uint8_t task ## _stack[stack_size + artx_STACK_OVERHEAD];   \
+        static const struct artx_tcb_rom task ## _rom PROGMEM = {          \
+          .rout = &routine,                                                \
+          .interval = ival,                                                \
+          .priority = prio                                                 \
+        };                                                                 \
+        static struct artx_tcb task = {                                    \
+          artx_MONITOR_TASK_INIT_(mon, task)                               \
+          artx_STACK_CHECK_INIT_(task)                                     \
+          .rom = &task ## _rom,                                            \
+          .schedule = offset,                                              \
+          .sp = (uint16_t) &task ## _stack[stack_size                      \
+                                             + artx_STACK_OVERHEAD - 1]    \
+        } artx_AUTO_INIT_TASK_(task)
+
+/**
+ *  Allocate User Task with Constant Data in Flash and Scheduling Offset
+ *
+ *  \hideinitializer
+ *
+ *  Use this macro instead of #ARTX_TASK_OFFS when ARTX is built
+ *  with #ARTX_USE_ROM_TCB. The routine run by the task is fixed
+ *  and must be defined using #ARTX_ROUT.
+ *
+ *  \param task                  The unique name of the task.
+ *
+ *  \param prio                  The unique user priority of the task.
+ *
+ *  \param ival                  The scheduling interval in multiples
+ *                               of the tick interval.
+ *
+ *  \param stack_size            The user stack size in bytes. The stack
+ *                               overhead required by the kernel will be
+ *                               added automatically.
+ *
+ *  \param offset                The scheduling offset in multiples
+ *                               of the tick interval.
+ *
+ *  \param routine               The name of the routine.
+ */
+#define ARTX_ROM_TASK_OFFS(task, prio, ival, stack_size, offset, routine)  \
+          ARTX_STATIC_ASSERT((artx_sched_diff_type) (ival) > 0);           \
+          ARTX_STATIC_ASSERT((prio) >= 0 && (prio) <= ARTX_PRIO_USER_MAX); \
+          artx_ALLOC_ROM_TASK(task, (prio) + artx_PRIO_USER_OFFSET, ival,  \
+                              stack_size, offset + 1, routine)
+
+/**
+ *  Allocate User Task with Constant Data in Flash
+ *
+ *  \hideinitializer
+ *
+ *  Use this macro instead of #ARTX_TASK when ARTX is built
+ *  with #ARTX_USE_ROM_TCB. The routine run by the task is fixed
+ *  and must be defined using #ARTX_ROUT.
+ *
+ *  \param task                  The unique name of the task.
+ *
+ *  \param prio                  The unique user priority of the task.
+ *
+ *  \param ival                  The scheduling interval in multiples
+ *                               of the tick interval.
+ *
+ *  \param stack_size            The user stack size in bytes. The stack
+ *                               overhead required by the kernel will be
+ *                               added automatically.
+ *
+ *  \param routine               The name of the routine.
+ */
+#define ARTX_ROM_TASK(task, prio, ival, stack_size, routine)               \
+          ARTX_ROM_TASK_OFFS(task, prio, ival, stack_size, 0, routine)
+
+/**
+ *  Allocate Idle Task with Constant Data in Flash
+ *
+ *  \hideinitializer
+ *
+ *  Use this macro instead of #ARTX_IDLE_TASK when ARTX is built
+ *  with #ARTX_USE_ROM_TCB. The routine run by the task is fixed
+ *  and must be defined using #ARTX_ROUT.
+ *
+ *  \param task                  The unique name of the task.
+ *
+ *  \param stack_size            The user stack size in bytes. The stack
+ *                               overhead required by the kernel will be
+ *                               added automatically.
+ *
+ *  \param routine               The name of the routine.
+ */
+#define ARTX_ROM_IDLE_TASK(task, stack_size, routine)                      \
+          artx_ALLOC_ROM_TASK(task, artx_PRIO_IDLE, 0, stack_size, 0, routine)
+
+#endif /* ARTX_USE_ROM_TCB */
+
 /**
  *  Allocate Routine
  *
@@ -410,14 +812,26 @@ struct ARTX_timeval
 #if ARTX_USE_MULTI_ROUT
 
 #define ARTX_ROUT(routine)                                                 \
+        artx_ALLOC_ROUT(routine)                                           \
+        static void routine ## _fun(void)
+
+/**
+ *  Allocate Routine Control Block
+ *
+ *  \internal
+ *  \hideinitializer
+ *
+ *  This macro will allocate and initialize the RCB of a routine
+ *  that is defined later on.
+ */
+#define artx_ALLOC_ROUT(routine)                                           \
         artx_NAME_DECL(routine)                                            \
         static void routine ## _fun(void);                                 \
         static struct artx_rcb routine = {                                 \
           artx_MONITOR_ROUT_INIT_(mon, routine)                            \
           artx_INITIAL_ROUT_STATE_                                         \
           .rout = &routine ## _fun                                         \
-        };                                                                 \
-        static void routine ## _fun(void)
+        };
 
 #else /* !ARTX_USE_MULTI_ROUT */
 
@@ -426,10 +840,175 @@ struct ARTX_timeval
 
 #endif /* ARTX_USE_MULTI_ROUT */
 
+#if ARTX_USE_AUTO_INIT && !ARTX_USE_ROM_TCB
+
+/**
+ *  Declare routine ahead of its definition
+ *
+ *  \internal
+ *  \hideinitializer
+ *
+ *  The RCB is completely defined up front, so it is only declared
+ *  once.
+ */
+#if ARTX_USE_MULTI_ROUT
+# define artx_ROUT_DECL_(routine)    artx_ALLOC_ROUT(routine)
+# define artx_ROUT_DEF_(routine)     static void routine ## _fun(void)
+#else
+# define artx_ROUT_DECL_(routine)    static void routine(void);
+# define artx_ROUT_DEF_(routine)     static void routine(void)
+#endif
+
+/**
+ *  Allocate Routine of Task
+ *
+ *  \hideinitializer
+ *
+ *  This macro works just like #ARTX_ROUT, but it will also add the
+ *  routine to the given task at startup, so you don't have to call
+ *  ARTX_task_push_rout(). Routines are added in the order in which
+ *  they appear in the linked object files.
+ *
+ *  This macro is only available with #ARTX_USE_AUTO_INIT. It is not
+ *  available with #ARTX_USE_ROM_TCB, where the routine is part of the
+ *  task declaration.
+ *
+ *  \param task                  The name of the task.
+ *
+ *  \param routine               The unique name of the routine.
+ */
+#define ARTX_TASK_ROUT(task, routine)                                      \
+        artx_ROUT_DECL_(routine)                                           \
+        static artxINITSECTION(8) void routine ## _auto_push(void)         \
+        {                                                                  \
+          ARTX_task_push_rout(&task, &routine);                            \
+        }                                                                  \
+        artx_ROUT_DEF_(routine)
+
+#endif /* ARTX_USE_AUTO_INIT && !ARTX_USE_ROM_TCB */
+
+#if ARTX_ENABLE_MODES
+
+/**
+ *  Mode name initializer
+ *
+ *  \internal
+ *  \hideinitializer
+ */
+#if ARTX_ENABLE_MONITOR
+# define artx_MODE_NAME_INIT_(mode)  .name = &mode ## _name[0],
+#else
+# define artx_MODE_NAME_INIT_(mode)
+#endif
+
+/**
+ *  Declare Task in Operating Mode
+ *
+ *  \hideinitializer
+ *
+ *  This macro declares a task that will be active in an operating
+ *  mode. It can only be used as an argument to #ARTX_MODE.
+ *
+ *  \param task                  The name of the task.
+ *
+ *  \param ival                  The scheduling interval of the task
+ *                               in this mode, in multiples of the
+ *                               tick interval.
+ *
+ *  \param offs                  The scheduling offset in multiples of
+ *                               the tick interval, relative to the
+ *                               tick at which the mode is switched.
+ */
+#define ARTX_MODE_TASK(task, ival, offs)                                   \
+          { .tcb = &task, .interval = ival, .offset = offs }
+
+/**
+ *  Declare Operating Mode
+ *
+ *  \hideinitializer
+ *
+ *  This macro declares an operating mode with its set of active
+ *  tasks. All tasks must still be initialized using ARTX_task_init()
+ *  before the scheduler is started. The idle task is always active
+ *  and must not be part of any mode.
+ *
+ *  Tasks may be listed in any order. Listing them in order of
+ *  priority, highest priority first, allows the kernel to switch
+ *  modes in time linear to the number of tasks.
+ *
+ *  \param mode                  The unique name of the mode.
+ *
+ *  \param ...                   One or more tasks declared using
+ *                               #ARTX_MODE_TASK.
+ */
+#define ARTX_MODE(mode, ...)                                               \
+        artx_NAME_DECL(mode)                                               \
+        static const struct artx_mode_task mode ## _tasks[] PROGMEM = {    \
+          __VA_ARGS__                                                      \
+        };                                                                 \
+        static const struct artx_mode mode PROGMEM = {                     \
+          artx_MODE_NAME_INIT_(mode)                                       \
+          .tasks = &mode ## _tasks[0],                                     \
+          .count = sizeof(mode ## _tasks)/sizeof(mode ## _tasks[0])        \
+        }
+
+#endif /* ARTX_ENABLE_MODES */
+
 void ARTX_task_init(struct artx_tcb *tcb);
 
 artxNAKED void ARTX_schedule(void);
 
+#if ARTX_TASK_POOL_SIZE
+
+#if ARTX_USE_MULTI_ROUT
+struct artx_tcb *ARTX_task_create(uint8_t prio, ARTX_interval_type interval,
+                                  ARTX_interval_type offset, struct artx_rcb *rout);
+#else
+struct artx_tcb *ARTX_task_create(uint8_t prio, ARTX_interval_type interval,
+                                  ARTX_interval_type offset, void (*rout)(void));
+#endif
+
+artxNORETURN void ARTX_task_exit(void);
+
+#endif
+
+#if ARTX_ENABLE_SPORADIC
+
+void ARTX_sporadic_init(struct artx_tcb *tcb, uint32_t capacity);
+
+void ARTX_sporadic_request(struct artx_tcb *tcb);
+
+#endif
+
+#if ARTX_USE_TASK_SUSPEND
+
+void ARTX_task_suspend(struct artx_tcb *tcb);
+
+void ARTX_task_resume(struct artx_tcb *tcb);
+
+/**
+ *  Get the state of a task
+ *
+ *  This routine returns the current state of a task.
+ *
+ *  \param tcb                   Pointer to the task control block.
+ */
+
+static inline enum ARTX_task_state ARTX_task_get_state(const struct artx_tcb *tcb)
+{
+  return tcb->state;
+}
+
+#endif
+
+#if ARTX_ENABLE_MODES
+
+void ARTX_mode_switch(const struct artx_mode *mode);
+
+const struct artx_mode *ARTX_mode_current(void);
+
+#endif
+
 /* TODO: Locking should be done by disabling the timer interrupt only.
  *       Agreed. Interrupts are safe to run on usertask stacks, as
  *       they can use the context stack, which should be enough.
@@ -443,7 +1022,7 @@ artxNAKED void ARTX_schedule(void);
 
 void ARTX_task_push_rout(struct artx_tcb *tcb, struct artx_rcb *rout);
 
-#else
+#elif !ARTX_USE_ROM_TCB
 
 /**
  *  Push routine on a tasks run queue
@@ -467,13 +1046,76 @@ static inline void ARTX_task_push_rout(struct artx_tcb *tcb, void (*rout)(void))
   tcb->rout = rout;
 }
 
-#endif // ARTX_USE_MULTI_ROUT
+#endif // ARTX_USE_MULTI_ROUT / !ARTX_USE_ROM_TCB
+
+#if !ARTX_SCHED_TABLE && !ARTX_USE_ROM_TCB
+
+#if ARTX_SCHED_EDF
 
-static inline void ARTX_task_set_interval(struct artx_tcb *tcb, uint16_t interval)
+void ARTX_task_set_interval(struct artx_tcb *tcb, ARTX_interval_type interval);
+
+#else
+
+/**
+ *  Set the interval of a task
+ *
+ *  Change the scheduling interval of a task. The new interval will
+ *  be used when the task is scheduled the next time.
+ *
+ *  \param tcb                   Pointer to the task control block.
+ *
+ *  \param interval              The scheduling interval in multiples
+ *                               of the tick interval.
+ */
+
+static inline void ARTX_task_set_interval(struct artx_tcb *tcb, ARTX_interval_type interval)
 {
   tcb->interval = interval;
 }
 
+#endif
+
+#endif // !ARTX_SCHED_TABLE && !ARTX_USE_ROM_TCB
+
+#if ARTX_ENABLE_BUDGET
+
+/**
+ *  Set the execution budget of a task
+ *
+ *  Set the maximum amount of time a task may run per release. The
+ *  budget is given in units of the timer used as the tick source,
+ *  i.e. in clock cycles divided by #ARTX_TICK_PRESCALER. A budget
+ *  of zero disables budget enforcement for the task.
+ *
+ *  Calls to this routine must be locked.
+ *
+ *  \param tcb                   Pointer to the task control block.
+ *
+ *  \param budget                The execution budget per release.
+ */
+
+static inline void ARTX_task_set_budget(struct artx_tcb *tcb, uint32_t budget)
+{
+  tcb->budget = budget;
+  tcb->budget_used = 0;
+}
+
+/**
+ *  Get the budget overrun count of a task
+ *
+ *  This routine returns the number of times a task has been
+ *  deferred because it has used up its execution budget.
+ *
+ *  \param tcb                   Pointer to the task control block.
+ */
+
+static inline uint16_t ARTX_task_get_overruns(const struct artx_tcb *tcb)
+{
+  return tcb->overruns;
+}
+
+#endif // ARTX_ENABLE_BUDGET
+
 #if ARTX_USE_ROUT_STATE
 
 /**
@@ -317,6 +317,10 @@
 #  error "ARTX_ENABLE_TICK_SYNC is not supported for this tick source"
 # endif
 
+# if ARTX_ENABLE_SAMPLING
+#  error "ARTX_ENABLE_SAMPLING is not supported for this tick source"
+# endif
+
 //=====================================================================
 #elif ARTX_TICK_SOURCE == ARTX_TIMER1_OVERFLOW
 //=====================================================================
@@ -332,6 +336,14 @@
 
 #  define artx_TIMER_TOP           (ARTX_TICK_DURATION - 1)
 
+# if ARTX_ENABLE_SAMPLING
+#  define artx_SAMPLE_VECTOR       TIMER1_COMPB_vect
+#  define artx_SAMPLE_REG          OCR1B
+#  define artx_SAMPLE_ENABLE       (1 << OCIE1B)
+# else
+#  define artx_SAMPLE_ENABLE       0
+# endif
+
 # if !defined(artx_TIMER1_BITS)
 
 #  error "TODO: currently unsupported"
@@ -344,7 +356,7 @@
           do {                                                        \
             TCCR1B = (1 << WGM12) | artx_PRESCALER;                   \
             OCR1A = artx_TIMER_TOP;                                   \
-            artx_TIMSK1 |= (1 << OCIE1A);                             \
+            artx_TIMSK1 |= (1 << OCIE1A) | artx_SAMPLE_ENABLE;        \
           } while (0)
 
 #  if ARTX_ENABLE_TICK_SYNC
@@ -367,7 +379,7 @@
             TCCR1 = (1 << CTC1) | artx_PRESCALER;                     \
             OCR1A = artx_TIMER_TOP;                                   \
             OCR1C = artx_TIMER_TOP;                                   \
-            artx_TIMSK1 |= (1 << OCIE1A);                             \
+            artx_TIMSK1 |= (1 << OCIE1A) | artx_SAMPLE_ENABLE;        \
           } while (0)
 
 #  if ARTX_ENABLE_TICK_SYNC
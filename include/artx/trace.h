@@ -0,0 +1,176 @@
+#ifndef artx_TRACE_H_
+#define artx_TRACE_H_
+
+/*******************************************************************************
+*
+* ARTX event tracing
+*
+********************************************************************************
+*
+* ARTX - A realtime executive library for Atmel AVR microcontrollers
+*
+* Copyright (C) 2007-2015 Marcus Holland-Moritz.
+*
+* ARTX is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* ARTX is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with ARTX.  If not, see <http://www.gnu.org/licenses/>.
+*
+*******************************************************************************/
+
+/**
+ *  \file artx/trace.h
+ *  \brief Event tracing
+ */
+
+#include <stdint.h>
+
+#include "artx/artx.h"
+#include "artx/handy.h"
+#include "artx/tick.h"
+
+#if ARTX_ENABLE_TRACE
+
+/**
+ *  Trace protocol version
+ *
+ *  \internal
+ */
+#define artx_TRACE_VERSION        1
+
+/**
+ *  Trace event types
+ *
+ *  \internal
+ *
+ *  The type of each recorded event. The meaning of the event's
+ *  data depends on the type.
+ */
+enum artx_trace_type
+{
+  artx_TE_TICK,                  //!< Kernel tick, data is the tick counter
+  artx_TE_SWITCH,                //!< Task switch, data is the new task's TCB
+  artx_TE_RELEASE,               //!< Task release, data is the task's TCB
+  artx_TE_ROUT_START,            //!< Routine start, data is the routine
+  artx_TE_ROUT_END,              //!< Routine end, data is the routine
+  artx_TE_ISR_ENTER,             //!< ISR entry, data is the routine
+  artx_TE_ISR_EXIT               //!< ISR exit, data is the routine
+};
+
+/**
+ *  Trace event
+ *
+ *  \internal
+ *
+ *  A single recorded event. A task switch ends the previous task's
+ *  time slice. Routines are identified by their (word) address and
+ *  tasks by the address of their TCB.
+ */
+struct artx_trace_event
+{
+  uint8_t  type;                 //!< Event type, see #artx_trace_type
+  uint16_t time;                 //!< Tick timer value, i.e. time since last tick
+  uint16_t data;                 //!< Event data
+};
+
+/**
+ *  Trace message header
+ *
+ *  \internal
+ *
+ *  This header is sent directly after the trace marker. It is
+ *  followed by \c count events.
+ */
+struct artx_trace_header
+{
+  uint8_t  version;              //!< Protocol version
+  uint8_t  hdr_size;             //!< Size of this structure
+  uint8_t  event_size;           //!< Size of a trace event
+  uint8_t  count;                //!< Number of events following
+  uint8_t  lost;                 //!< Number of events lost since last message
+  uint16_t tick_duration;        //!< Nominal tick duration in counter units
+  uint16_t tick_prescaler;       //!< Counter prescaler used for tick
+  uint32_t clock_frequency;      //!< System clock frequency
+};
+
+extern struct artx_trace_event artx_trace_buf[ARTX_TRACE_SIZE];
+extern volatile uint8_t artx_trace_head;
+extern volatile uint8_t artx_trace_tail;
+extern uint8_t artx_trace_lost;
+extern uint16_t artx_trace_ticks;
+
+void artx_trace_transmit(void);
+
+/**
+ *  Record trace event
+ *
+ *  \internal
+ *
+ *  This routine records a single event in the trace buffer. If
+ *  the buffer is full, the event is dropped and counted as lost.
+ *
+ *  Calls to this routine must be locked.
+ *
+ *  \param type                  Event type.
+ *
+ *  \param data                  Event data.
+ */
+static inline void artx_trace(uint8_t type, uint16_t data)
+{
+  uint8_t head = artx_trace_head;
+
+  if (artxLIKELY((uint8_t) (head - artx_trace_tail) < ARTX_TRACE_SIZE))
+  {
+    struct artx_trace_event *ev = &artx_trace_buf[head & (ARTX_TRACE_SIZE - 1)];
+
+    ev->type = type;
+    ev->time = artx_TIMER_REG;
+    ev->data = data;
+
+    artx_trace_head = head + 1;
+  }
+  else if (artx_trace_lost < UINT8_MAX)
+  {
+    artx_trace_lost++;
+  }
+}
+
+/**
+ *  Record trace event
+ *
+ *  \internal
+ *  \hideinitializer
+ *
+ *  Records an event if tracing is enabled and does nothing otherwise.
+ *  Calls to this macro must be locked.
+ */
+# define artx_TRACE(type, data)   artx_trace(type, (uint16_t) (data))
+
+/**
+ *  Record kernel tick
+ *
+ *  \internal
+ *  \hideinitializer
+ *
+ *  Records a tick event carrying the number of ticks so far, which
+ *  allows tools/artx-trace to recover the time base after events
+ *  have been lost.
+ */
+# define artx_TRACE_TICK()        artx_trace(artx_TE_TICK, ++artx_trace_ticks)
+
+#else /* !ARTX_ENABLE_TRACE */
+
+# define artx_TRACE(type, data)   do { } while (0)
+# define artx_TRACE_TICK()        do { } while (0)
+
+#endif /* ARTX_ENABLE_TRACE */
+
+#endif
@@ -58,6 +58,35 @@
 extern volatile uint8_t artx_lock_level;
 #endif
 
+#if ARTX_ENABLE_CLI_PROFILE
+
+void artx_cli_begin(uint16_t site);
+void artx_cli_end(void);
+
+/**
+ *  Begin interrupt disabled window
+ *
+ *  \internal
+ *  \hideinitializer
+ *
+ *  Starts measuring an interrupt disabled window if interrupts were
+ *  enabled according to \a sreg, i.e. the status register saved
+ *  before disabling interrupts. The window is identified by the
+ *  (word) address of the code using this macro.
+ */
+# define artx_CLI_ENTER(sreg)                                               \
+          do {                                                              \
+            if ((sreg) & _BV(SREG_I))                                       \
+            {                                                               \
+              uint16_t site_;                                               \
+              asm volatile ("1: ldi %A0, pm_lo8(1b)" "\n\t"                 \
+                            "ldi %B0, pm_hi8(1b)" : "=d" (site_));          \
+              artx_cli_begin(site_);                                        \
+            }                                                               \
+          } while (0)
+
+#endif
+
 /**
  *  Lock a user task
  *
@@ -76,10 +105,16 @@ extern volatile uint8_t artx_lock_level;
  */
 static inline void ARTX_lock(void)
 {
+#if ARTX_ENABLE_CLI_PROFILE
+  uint8_t sreg = SREG;
+#endif
   asm volatile ("cli");
 #if ARTX_ALLOW_NESTED_LOCKS
   artx_lock_level++;
 #endif
+#if ARTX_ENABLE_CLI_PROFILE
+  artx_CLI_ENTER(sreg);
+#endif
 }
 
 /**
@@ -99,6 +134,9 @@ static inline void ARTX_unlock(void)
   if (artx_lock_level-- == 1)
 #endif
   {
+#if ARTX_ENABLE_CLI_PROFILE
+    artx_cli_end();
+#endif
     asm volatile ("sei");
   }
 }
@@ -114,7 +152,13 @@ static inline void ARTX_unlock(void)
  */
 static inline void ARTX_disable_int(void)
 {
+#if ARTX_ENABLE_CLI_PROFILE
+  uint8_t sreg = SREG;
+  asm volatile ("cli");
+  artx_CLI_ENTER(sreg);
+#else
   asm volatile ("cli");
+#endif
 }
 
 /**
@@ -127,6 +171,9 @@ static inline void ARTX_disable_int(void)
  */
 static inline void ARTX_enable_int(void)
 {
+#if ARTX_ENABLE_CLI_PROFILE
+  artx_cli_end();
+#endif
   asm volatile ("sei");
 }
 
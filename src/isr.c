@@ -47,114 +47,100 @@
 
 /*===== STATIC VARIABLES =====================================================*/
 
-#if 0 && ARTX_ENABLE_MONITOR
+#if ARTX_ENABLE_ISR_STACK
 
-uint8_t artxASMONLY artx_REG;  //!< register temporary storage \internal
-uint8_t artxASMONLY artx_SPL;  //!< stack ptr lo-byte temp storage \internal
-uint8_t artxASMONLY artx_SPH;  //!< stack ptr hi-byte temp storage \internal
+uint8_t artxASMONLY artx_isr_R31;   //!< R31 temporary storage \internal
+uint16_t artxASMONLY artx_isr_SP;   //!< task stack pointer storage \internal
 
-#endif // ARTX_ENABLE_MONITOR
+#endif // ARTX_ENABLE_ISR_STACK
 
 
 /*===== STATIC FUNCTIONS =====================================================*/
 
 /*===== FUNCTIONS ============================================================*/
 
-#if 0 && ARTX_ENABLE_MONITOR
+#if ARTX_ENABLE_ISR_STACK
 
-void artx_call_isr(void (*isr)(void))
+#ifdef RAMPZ
+# define artx_RAMPZ_OPERANDS   : : [rampz] "I" (_SFR_IO_ADDR(RAMPZ))
+#else
+# define artx_RAMPZ_OPERANDS
+#endif
+
+/**
+ *  Run an interrupt service routine on the kernel stack
+ *
+ *  \internal
+ *
+ *  This routine is entered from an interrupt vector declared using
+ *  ARTX_ISR() after it has already switched to the kernel stack. The
+ *  Z register holds the address of the actual routine. As that is a
+ *  regular function, it saves all call-saved registers itself, so we
+ *  only need to save SREG, RAMPZ if present, and the call-used
+ *  registers.
+ *
+ *  Interrupts are disabled all the time, so neither the kernel stack
+ *  nor the temporary storage can be used by anyone else.
+ */
+
+void artx_call_isr(void)
 {
   asm volatile (
 
-    "in    r31, __SREG__             \n\t" /* load SREG              */
-
-    "push  r31                       \n\t" /* save registers         */
-    "push  r30                       \n\t"
-    "push  r29                       \n\t"
-    "push  r28                       \n\t"
-    "push  r27                       \n\t"
-    "push  r26                       \n\t"
-    "push  r25                       \n\t"
-    "push  r24                       \n\t"
-    "push  r23                       \n\t"
-    "push  r22                       \n\t"
-    "push  r21                       \n\t"
-    "push  r20                       \n\t"
-    "push  r19                       \n\t"
-    "push  r18                       \n\t"
-    "push  r17                       \n\t"
-    "push  r16                       \n\t"
-    "push  r15                       \n\t"
-    "push  r14                       \n\t"
-    "push  r13                       \n\t"
-    "push  r12                       \n\t"
-    "push  r11                       \n\t"
-    "push  r10                       \n\t"
-    "push  r9                        \n\t"
-    "push  r8                        \n\t"
-    "push  r7                        \n\t"
-    "push  r6                        \n\t"
-    "push  r5                        \n\t"
-    "push  r4                        \n\t"
-    "push  r3                        \n\t"
-    "push  r2                        \n\t"
-    "push  r1                        \n\t"
+    "push  r0                        \n\t" /* save R0                */
+    "in    r0, __SREG__              \n\t" /* save SREG              */
     "push  r0                        \n\t"
+#ifdef RAMPZ
+    "in    r0, %[rampz]              \n\t" /* save RAMPZ             */
+    "push  r0                        \n\t"
+#endif
+    "push  r1                        \n\t" /* save call-used regs    */
+    "push  r18                       \n\t"
+    "push  r19                       \n\t"
+    "push  r20                       \n\t"
+    "push  r21                       \n\t"
+    "push  r22                       \n\t"
+    "push  r23                       \n\t"
+    "push  r24                       \n\t"
+    "push  r25                       \n\t"
+    "push  r26                       \n\t"
+    "push  r27                       \n\t"
 
     "clr   __zero_reg__              \n\t"
 
-  );
-
-  isr();
-
-  asm volatile (
+    "icall                           \n\t" /* run the routine        */
 
-    "pop   r0                        \n\t" /* restore registers      */
-    "pop   r1                        \n\t"
-    "pop   r2                        \n\t"
-    "pop   r3                        \n\t"
-    "pop   r4                        \n\t"
-    "pop   r5                        \n\t"
-    "pop   r6                        \n\t"
-    "pop   r7                        \n\t"
-    "pop   r8                        \n\t"
-    "pop   r9                        \n\t"
-    "pop   r10                       \n\t"
-    "pop   r11                       \n\t"
-    "pop   r12                       \n\t"
-    "pop   r13                       \n\t"
-    "pop   r14                       \n\t"
-    "pop   r15                       \n\t"
-    "pop   r16                       \n\t"
-    "pop   r17                       \n\t"
-    "pop   r18                       \n\t"
-    "pop   r19                       \n\t"
-    "pop   r20                       \n\t"
-    "pop   r21                       \n\t"
-    "pop   r22                       \n\t"
-    "pop   r23                       \n\t"
-    "pop   r24                       \n\t"
-    "pop   r25                       \n\t"
+    "pop   r27                       \n\t" /* restore call-used regs */
     "pop   r26                       \n\t"
-    "pop   r27                       \n\t"
-    "pop   r28                       \n\t"
-    "pop   r29                       \n\t"
-    "pop   r30                       \n\t"
-    "pop   r31                       \n\t"
-
-    "out   __SREG__, r31             \n\t" /* restore SREG           */
-
-    "lds   r31, artx_SPL             \n\t" /* restore SP             */
+    "pop   r25                       \n\t"
+    "pop   r24                       \n\t"
+    "pop   r23                       \n\t"
+    "pop   r22                       \n\t"
+    "pop   r21                       \n\t"
+    "pop   r20                       \n\t"
+    "pop   r19                       \n\t"
+    "pop   r18                       \n\t"
+    "pop   r1                        \n\t"
+#ifdef RAMPZ
+    "pop   r0                        \n\t" /* restore RAMPZ          */
+    "out   %[rampz], r0              \n\t"
+#endif
+    "pop   r0                        \n\t" /* restore SREG           */
+    "out   __SREG__, r0              \n\t"
+    "pop   r0                        \n\t" /* restore R0             */
+    "pop   r30                       \n\t" /* restore R30            */
+
+    "lds   r31, artx_isr_SP          \n\t" /* switch to task stack   */
     "out   __SP_L__, r31             \n\t"
-    "lds   r31, artx_SPH             \n\t"
+    "lds   r31, artx_isr_SP + 1      \n\t"
     "out   __SP_H__, r31             \n\t"
 
-    "lds   r31, artx_REG             \n\t" /* restore R31            */
+    "lds   r31, artx_isr_R31         \n\t" /* restore R31            */
 
     "reti                            \n\t" /* return from interrupt  */
 
+    artx_RAMPZ_OPERANDS
   );
 }
 
-#endif // ARTX_ENABLE_MONITOR
-
+#endif // ARTX_ENABLE_ISR_STACK
@@ -0,0 +1,203 @@
+/*******************************************************************************
+*
+* ARTX binary logging
+*
+********************************************************************************
+*
+* ARTX - A realtime executive library for Atmel AVR microcontrollers
+*
+* Copyright (C) 2007-2015 Marcus Holland-Moritz.
+*
+* ARTX is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* ARTX is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with ARTX.  If not, see <http://www.gnu.org/licenses/>.
+*
+*******************************************************************************/
+
+/**
+ *  \file log.c
+ *  \brief Binary logging
+ */
+
+
+/*===== GLOBAL INCLUDES ======================================================*/
+
+#include <avr/io.h>
+
+
+/*===== LOCAL INCLUDES =======================================================*/
+
+#include "artx/log.h"
+#include "artx/serial.h"
+#include "artx/util.h"
+
+#if ARTX_ENABLE_LOG
+
+
+/*===== DEFINES ==============================================================*/
+
+#define artx_LOG_INDEX(i)   ((i) & (ARTX_LOG_SIZE - 1))
+
+
+/*===== TYPEDEFS =============================================================*/
+
+/*===== STATIC FUNCTION PROTOTYPES ===========================================*/
+
+/*===== EXTERNAL VARIABLES ===================================================*/
+
+/*===== GLOBAL VARIABLES =====================================================*/
+
+/**
+ *  Log buffer
+ *
+ *  \internal
+ *
+ *  Ring buffer holding the log records. Records are written at
+ *  #artx_log_head by artx_log_write() and read at #artx_log_tail
+ *  by artx_log_transmit(). Both indices are free-running.
+ */
+uint8_t artx_log_buf[ARTX_LOG_SIZE];
+
+volatile uint8_t artx_log_head;    //!< Next byte to write \internal
+volatile uint8_t artx_log_tail;    //!< Next byte to send \internal
+uint8_t artx_log_lost;             //!< Records lost since last message \internal
+
+
+/*===== STATIC VARIABLES =====================================================*/
+
+/**
+ *  ARTX log frame marker
+ *
+ *  \internal
+ *
+ *  This marker is sent at the beginning of each log message to
+ *  synchronize the serial stream.
+ */
+static const char artx_log_marker[] PROGMEM = "ARTL";
+
+
+/*===== STATIC FUNCTIONS =====================================================*/
+
+/*===== FUNCTIONS ============================================================*/
+
+/**
+ *  Store log record
+ *
+ *  \internal
+ *
+ *  This routine is called by ARTX_LOG() and stores a single record
+ *  in the log buffer. As it can be called from any task and from
+ *  interrupt service routines, interrupts are disabled while the
+ *  record is copied. The previous interrupt state is restored
+ *  afterwards.
+ *
+ *  \param fmt                   Format string in flash.
+ *
+ *  \param args                  Argument bytes.
+ *
+ *  \param size                  Number of argument bytes.
+ */
+
+void artx_log_write(PGM_P fmt, const void *args, uint8_t size)
+{
+  const uint8_t *src = (const uint8_t *) args;
+  uint8_t sreg = SREG;
+
+  ARTX_disable_int();
+
+  uint8_t head = artx_log_head;
+
+  if (artxLIKELY((uint8_t) (head - artx_log_tail) <= ARTX_LOG_SIZE - 3 - size))
+  {
+    artx_log_buf[artx_LOG_INDEX(head++)] = (uint16_t) fmt;
+    artx_log_buf[artx_LOG_INDEX(head++)] = (uint16_t) fmt >> 8;
+    artx_log_buf[artx_LOG_INDEX(head++)] = size;
+
+    while (size--)
+    {
+      artx_log_buf[artx_LOG_INDEX(head++)] = *src++;
+    }
+
+    artx_log_head = head;
+  }
+  else if (artx_log_lost < UINT8_MAX)
+  {
+    artx_log_lost++;
+  }
+
+  if (sreg & _BV(SREG_I))
+  {
+    ARTX_enable_int();
+  }
+}
+
+/**
+ *  Transmit log records
+ *
+ *  \internal
+ *
+ *  This routine transmits all records that are currently in the
+ *  log buffer. It is called from the idle task with interrupts
+ *  enabled. As records are never overwritten before they have been
+ *  sent, the buffer is read without locking.
+ */
+
+void artx_log_transmit(void)
+{
+  static struct artx_log_header header;
+
+  uint8_t tail = artx_log_tail;
+  uint8_t size = artx_log_head - tail;
+
+  ARTX_disable_int();
+
+  uint8_t lost = artx_log_lost;
+  artx_log_lost = 0;
+
+  ARTX_enable_int();
+
+  if (size == 0 && lost == 0)
+  {
+    return;
+  }
+
+  header.version = artx_LOG_VERSION;
+  header.hdr_size = sizeof(struct artx_log_header);
+  header.size = size;
+  header.lost = lost;
+
+#if ARTX_ENABLE_SERIAL
+  ARTX_serial_tx_string_pgm(artx_log_marker);
+  ARTX_serial_tx_data(&header, sizeof(struct artx_log_header));
+#endif
+
+  while (size)
+  {
+    /* send contiguous chunks up to the end of the buffer */
+    uint8_t chunk = ARTX_LOG_SIZE - artx_LOG_INDEX(tail);
+
+    if (chunk > size)
+    {
+      chunk = size;
+    }
+
+#if ARTX_ENABLE_SERIAL
+    ARTX_serial_tx_data(&artx_log_buf[artx_LOG_INDEX(tail)], chunk);
+#endif
+
+    tail += chunk;
+    size -= chunk;
+    artx_log_tail = tail;
+  }
+}
+
+#endif
@@ -39,38 +39,61 @@
 
 #include "artx/monitor.h"
 #include "artx/serial.h"
+#include "artx/stack.h"
 #include "artx/task.h"
 #include "artx/tick.h"
+#include "artx/util.h"
 
 #if ARTX_ENABLE_MONITOR
 
 
 /*===== DEFINES ==============================================================*/
 
-/**
- *  Stack sentinel
- *
- *  \internal
- *
- *  This byte is used to identify unused bytes on the stack.
- */
-#define artx_STACK_SENTINEL 0xC3
-
-
 /*===== TYPEDEFS =============================================================*/
 
 /*===== STATIC FUNCTION PROTOTYPES ===========================================*/
 
 static void update_stack(struct artx_monitor_task *mon);
+static void reset_cycles(struct artx_monitor_cycles *cyc);
+static void collect_info(struct artx_monitor_info *info, struct artx_monitor_cycles *cyc,
+                         uint8_t intervals);
+
+#if ARTX_USE_MULTI_ROUT
+static void carry_rout(struct artx_monitor_rout *mon, uint8_t b);
+#endif
+
+#if ARTX_ENABLE_STATS
+static uint8_t update_stats(struct artx_monitor_task *mon, const struct artx_monitor_info *info);
+#endif
+
+#if ARTX_ENABLE_HISTOGRAM && ARTX_ENABLE_SERIAL
+static void transmit_histogram(uint16_t *hist);
+#endif
 
 
 /*===== EXTERNAL VARIABLES ===================================================*/
 
-extern struct artx_tcb *artx_task_list;
+#if ARTX_ENABLE_MODES
+extern const struct artx_mode *artx_current_mode;
+#endif
 
 
 /*===== GLOBAL VARIABLES =====================================================*/
 
+#if ARTX_ENABLE_STATS
+
+/**
+ *  CPU load in percent
+ *
+ *  \internal
+ *
+ *  Share of CPU time not spent in the idle task during the last
+ *  complete monitoring interval.
+ */
+uint8_t artx_stats_cpu_load;
+
+#endif
+
 /*===== STATIC VARIABLES =====================================================*/
 
 /**
@@ -90,31 +113,249 @@ static const char artx_marker[] PROGMEM = "ARTX";
  */
 struct artx_monitor_control artx_monitor_ctl;
 
+/**
+ *  Kernel cycle accounting
+ *
+ *  \internal
+ *
+ *  Cycles spent in the kernel, i.e. in task switches and tick
+ *  processing.
+ */
+struct artx_monitor_account artx_monitor_kernel;
+
+/**
+ *  Interrupt service routine list
+ *
+ *  \internal
+ *
+ *  List of all interrupt service routines declared using ARTX_ISR().
+ *  The routines link themselves into this list during startup.
+ */
+struct artx_monitor_account *artx_monitor_isr_list;
+
+#if ARTX_ENABLE_PROFILE
+
+/**
+ *  Program counter histograms
+ *
+ *  \internal
+ *
+ *  The kernel adds samples to the histogram selected by
+ *  artx_monitor_control::bank during the current monitoring interval,
+ *  while the other one holds the samples of the last interval.
+ */
+struct artx_monitor_profile artx_monitor_prof[2];
+
+#endif
+
+#if ARTX_ENABLE_CLI_PROFILE
+
+/**
+ *  Interrupt disabled window statistics
+ *
+ *  \internal
+ *
+ *  Hash table holding the statistics for each site that disabled
+ *  interrupts. Unlike most other monitoring information, these are
+ *  never reset.
+ */
+struct artx_monitor_cli artx_monitor_cli[ARTX_CLI_SITES];
+
+uint16_t artx_monitor_cli_other;   //!< Windows of sites not in table \internal
+
+#endif
+
+
+#if ARTX_ENABLE_CLI_PROFILE
+
+static uint16_t artx_cli_site;            //!< Site of current window \internal
+static artx_TIMER_TYPE artx_cli_start;    //!< Start of current window \internal
+
+#endif
+
 
 /*===== STATIC FUNCTIONS =====================================================*/
 
+#if ARTX_ENABLE_HISTOGRAM && ARTX_ENABLE_SERIAL
+
+/**
+ *  Transmit execution time histogram
+ *
+ *  \internal
+ *
+ *  This routine transmits the execution time histogram of the task
+ *  or routine that has just been sent and clears it for the next
+ *  monitoring interval.
+ *
+ *  \param hist                  Pointer to histogram bins.
+ */
+
+static void transmit_histogram(uint16_t *hist)
+{
+  ARTX_serial_tx_byte('H');
+  ARTX_serial_tx_byte(ARTX_HISTOGRAM_BINS);
+  ARTX_serial_tx_byte(ARTX_HISTOGRAM_SHIFT);
+  ARTX_serial_tx_data(hist, ARTX_HISTOGRAM_BINS*sizeof(uint16_t));
+
+  for (uint8_t i = 0; i < ARTX_HISTOGRAM_BINS; i++)
+  {
+    hist[i] = 0;
+  }
+}
+
+#endif
+
 /**
  *  Update stack information
  *
  *  \internal
  *
- *  This routine determines the a task's stack usage and updates
- *  the monitoring info accordingly.
+ *  This routine updates a task's stack watermark and the stack usage
+ *  in the monitoring info accordingly. The scan is incremental, see
+ *  #ARTX_STACK_SCAN_BUDGET.
  *
  *  \param mon                   Pointer to task monitoring data.
  */
 
 static void update_stack(struct artx_monitor_task *mon)
 {
-  uint16_t n = mon->stack_size + artx_EXTRA_STACK;
-  uint8_t *p = mon->stack_ptr;
+  uint16_t used = mon->stack_size + artx_EXTRA_STACK - artx_stack_scan(&mon->stack);
+
+  mon->stack_usage = used - artx_TASK_EXTRA_STACK;
+}
+
+/**
+ *  Reset cycle accounting info
+ *
+ *  \internal
+ *
+ *  \param cyc                   Pointer to cycle accounting info.
+ */
+
+static void reset_cycles(struct artx_monitor_cycles *cyc)
+{
+  cyc->total_cycles = 0;
+  cyc->peak_cycles = 0;
+  cyc->run_counter = 0;
+}
+
+/**
+ *  Collect monitoring info
+ *
+ *  \internal
+ *
+ *  This routine moves the cycles collected in a bank that is not
+ *  currently updated by the kernel to the info to be transmitted.
+ *
+ *  \param info                  Pointer to info to be transmitted.
+ *
+ *  \param cyc                   Pointer to cycle accounting info.
+ *
+ *  \param intervals             Number of intervals covered.
+ */
+
+static void collect_info(struct artx_monitor_info *info, struct artx_monitor_cycles *cyc,
+                         uint8_t intervals)
+{
+  info->total_cycles = cyc->total_cycles;
+  info->peak_cycles = cyc->peak_cycles;
+  info->run_counter = cyc->run_counter;
+  info->intervals = intervals;
+
+  reset_cycles(cyc);
+}
+
+#if ARTX_USE_MULTI_ROUT
+
+/**
+ *  Carry over routine monitoring info
+ *
+ *  \internal
+ *
+ *  A routine may complete during an interval in which its task
+ *  doesn't. As routines are only transmitted along with their task,
+ *  this routine merges the info of the routine into the bank that
+ *  is currently collecting.
+ *
+ *  \param mon                   Pointer to routine monitoring data.
+ *
+ *  \param b                     Bank to be carried over.
+ */
+
+static void carry_rout(struct artx_monitor_rout *mon, uint8_t b)
+{
+  register struct artx_monitor_cycles *from = &mon->bank[b];
+  register struct artx_monitor_cycles *to = &mon->bank[b ^ 1];
+
+  ARTX_disable_int();
+
+  to->total_cycles += from->total_cycles;
+  to->run_counter += from->run_counter;
+
+  if (from->peak_cycles > to->peak_cycles)
+  {
+    to->peak_cycles = from->peak_cycles;
+  }
+
+#if ARTX_ENABLE_HISTOGRAM
+  for (uint8_t i = 0; i < ARTX_HISTOGRAM_BINS; i++)
+  {
+    uint16_t count = mon->hist[b][i];
+
+    mon->hist[b ^ 1][i] = count < UINT16_MAX - mon->hist[b ^ 1][i]
+                        ? mon->hist[b ^ 1][i] + count : UINT16_MAX;
+    mon->hist[b][i] = 0;
+  }
+#endif
+
+  ARTX_enable_int();
+
+  reset_cycles(from);
+}
+
+#endif
+
+#if ARTX_ENABLE_STATS
+
+/**
+ *  Update task statistics
+ *
+ *  \internal
+ *
+ *  This routine takes a snapshot of a task's monitoring info when
+ *  it is transmitted.
+ *
+ *  \param mon                   Pointer to task monitoring data.
+ *
+ *  \param info                  Pointer to info to be transmitted.
+ *
+ *  \returns Share of CPU time spent in the task in percent.
+ */
+
+static uint8_t update_stats(struct artx_monitor_task *mon, const struct artx_monitor_info *info)
+{
+  uint32_t monitor_cycles = (uint32_t) artx_TIMER_TOP*artx_monitor_ctl.interval*info->intervals;
+  uint32_t load = info->total_cycles/(monitor_cycles/100 + 1);
 
-  while (*p++ == artx_STACK_SENTINEL && --n > 0)
-  { }
+  if (load > 100)
+  {
+    load = 100;
+  }
+
+  ARTX_lock();
+  mon->stats.total_cycles = info->total_cycles;
+  mon->stats.peak_cycles = info->peak_cycles;
+  mon->stats.run_counter = info->run_counter;
+  mon->stats.stack_size = info->stack_size;
+  mon->stats.stack_usage = info->stack_usage;
+  mon->stats.load = load;
+  ARTX_unlock();
 
-  mon->stack_usage = n - artx_TASK_EXTRA_STACK;
+  return load;
 }
 
+#endif
+
 
 /*===== FUNCTIONS ============================================================*/
 
@@ -131,13 +372,7 @@ static void update_stack(struct artx_monitor_task *mon)
 
 void artx_monitor_task_init(struct artx_monitor_task *mon)
 {
-  uint16_t i = mon->stack_size + artx_EXTRA_STACK;
-  uint8_t *p = mon->stack_ptr;
-
-  while (i-- > 0)
-  {
-    *p++ = artx_STACK_SENTINEL;
-  }
+  artx_stack_init(&mon->stack, mon->stack_size + artx_EXTRA_STACK);
 }
 
 /**
@@ -145,19 +380,30 @@ void artx_monitor_task_init(struct artx_monitor_task *mon)
  *
  *  \internal
  *
- *  This routine transmits the monitoring infomation for all tasks
- *  and routines that are in #artx_MS_READY state.
+ *  This routine is run by the idle task with interrupts enabled
+ *  after the kernel has switched banks. It transmits the monitoring
+ *  infomation collected in the other bank for all tasks and routines
+ *  that have completed at least one run, followed by the cycles spent
+ *  in interrupt service routines and in the kernel and, with
+ *  #ARTX_ENABLE_PROFILE, the program counter samples taken during the
+ *  last monitoring interval. With #ARTX_ENABLE_CLI_PROFILE, the
+ *  interrupt disabled window statistics are sent as well. The bank
+ *  is cleared for reuse and the kernel may switch banks again once
+ *  this routine returns.
  */
 
 void artx_monitor_transmit(void)
 {
   static struct artx_monitor_header header;
+  static struct artx_monitor_info info;
+  uint8_t b = artx_monitor_ctl.bank ^ 1;
+  uint8_t intervals = artx_monitor_ctl.intervals[b];
 
   header.version = artx_MONITOR_VERSION;
   header.hdr_size = sizeof(struct artx_monitor_header);
-  header.tcb_size = offsetof(struct artx_tcb, mon.name);
+  header.tcb_size = offsetof(struct artx_tcb, mon);
 #if ARTX_USE_MULTI_ROUT
-  header.rcb_size = offsetof(struct artx_rcb, mon.name);
+  header.rcb_size = offsetof(struct artx_rcb, mon);
 #else
   header.rcb_size = 0;
 #endif
@@ -170,76 +416,323 @@ void artx_monitor_transmit(void)
   header.tick_prescaler = ARTX_TICK_PRESCALER;
   header.monitor_interval = artx_monitor_ctl.interval;
   header.clock_frequency = ARTX_CLOCK_FREQUENCY;
+  header.cyc_size = sizeof(struct artx_monitor_cycles);
+  header.info_size = sizeof(struct artx_monitor_info);
+  header.intervals = intervals;
 
 #if ARTX_ENABLE_SERIAL
   ARTX_serial_tx_string_pgm(artx_marker);
   ARTX_serial_tx_data(&header, sizeof(struct artx_monitor_header));
 #endif
 
-  register struct artx_tcb *tcb = artx_task_list;
+#if ARTX_ENABLE_MODES
+  if (artx_current_mode)
+  {
+#if ARTX_ENABLE_SERIAL
+    ARTX_serial_tx_byte('M');
+    ARTX_serial_tx_string_pgm((PGM_P) pgm_read_word(&artx_current_mode->name));
+    ARTX_serial_tx_byte('\0');
+#endif
+  }
+#endif
 
-  while (tcb)
+  /* tasks may be linked and unlinked while we're transmitting */
+  for (register struct artx_tcb *tcb = artx_task_walk(0); tcb; tcb = artx_task_walk(tcb))
   {
-    if (tcb->mon.state == artx_MS_READY)
+    register struct artx_monitor_cycles *cyc = &tcb->mon.bank[b];
+    uint8_t sent = cyc->run_counter > 0;
+
+    if (sent)
     {
       update_stack(&tcb->mon);
+      collect_info(&info, cyc, tcb->mon.intervals + intervals);
+      info.stack_size = tcb->mon.stack_size;
+      info.stack_usage = tcb->mon.stack_usage;
+
+#if ARTX_ENABLE_STATS
+      uint8_t load = update_stats(&tcb->mon, &info);
+
+      /* the idle task is always the last one in the list */
+      if (tcb->next == NULL)
+      {
+        artx_stats_cpu_load = 100 - load;
+      }
+#endif
 
 #if ARTX_ENABLE_SERIAL
       ARTX_serial_tx_byte('T');
-      ARTX_serial_tx_data(tcb, offsetof(struct artx_tcb, mon.name));
+      ARTX_serial_tx_data(tcb, offsetof(struct artx_tcb, mon));
+      ARTX_serial_tx_data(&info, sizeof(struct artx_monitor_info));
       ARTX_serial_tx_string_pgm(tcb->mon.name);
       ARTX_serial_tx_byte('\0');
+#if ARTX_ENABLE_HISTOGRAM
+      transmit_histogram(tcb->mon.hist[b]);
+#endif
+#if ARTX_ENABLE_LATENCY
+      ARTX_serial_tx_byte('J');
+      ARTX_serial_tx_byte(sizeof(struct artx_monitor_latency));
+      ARTX_serial_tx_data(&tcb->mon.lat[b], sizeof(struct artx_monitor_latency));
+#endif
 #endif
 
       /* reset content */
-      tcb->mon.run_counter = 0;
-      tcb->mon.peak_cycles = 0;
-      tcb->mon.total_cycles = 0;
-      tcb->mon.intervals = 1;
-      tcb->mon.state = artx_MS_SENT;
+      tcb->mon.intervals = 0;
+#if ARTX_ENABLE_LATENCY
+      tcb->mon.lat[b].count = 0;
+#endif
+    }
+    else
+    {
+      /* the interval will be covered by the next completed run */
+      tcb->mon.intervals += intervals;
+    }
 
 #if ARTX_USE_MULTI_ROUT
-      register struct artx_rcb *rcb = tcb->rout;
+    for (register struct artx_rcb *rcb = tcb->rout; rcb; rcb = rcb->next)
+    {
+      cyc = &rcb->mon.bank[b];
 
-      while (rcb)
+      if (sent && cyc->run_counter > 0)
       {
-        if (rcb->mon.state == artx_MS_READY)
-        {
+        collect_info(&info, cyc, rcb->mon.intervals + intervals);
+        info.stack_size = 0;
+        info.stack_usage = 0;
+
 #if ARTX_ENABLE_SERIAL
-          ARTX_serial_tx_byte('R');
-          ARTX_serial_tx_data(rcb, offsetof(struct artx_rcb, mon.name));
-          ARTX_serial_tx_string_pgm(rcb->mon.name);
-          ARTX_serial_tx_byte('\0');
-#endif
-
-          /* reset content */
-          rcb->mon.run_counter = 0;
-          rcb->mon.peak_cycles = 0;
-          rcb->mon.total_cycles = 0;
-          rcb->mon.intervals = 1;
-          rcb->mon.state = artx_MS_SENT;
+        ARTX_serial_tx_byte('R');
+        ARTX_serial_tx_data(rcb, offsetof(struct artx_rcb, mon));
+        ARTX_serial_tx_data(&info, sizeof(struct artx_monitor_info));
+        ARTX_serial_tx_string_pgm(rcb->mon.name);
+        ARTX_serial_tx_byte('\0');
+#if ARTX_ENABLE_HISTOGRAM
+        transmit_histogram(rcb->mon.hist[b]);
+#endif
+#endif
+
+        /* reset content */
+        rcb->mon.intervals = 0;
+      }
+      else
+      {
+        if (cyc->run_counter > 0)
+        {
+          /* the task hasn't completed yet, so the routine can't be sent */
+          carry_rout(&rcb->mon, b);
         }
 
-        rcb = rcb->next;
+        rcb->mon.intervals += intervals;
       }
-#endif
     }
+#endif
+  }
 
-    tcb = tcb->next;
+  for (register struct artx_monitor_account *isr = artx_monitor_isr_list; isr; isr = isr->next)
+  {
+#if ARTX_ENABLE_SERIAL
+    ARTX_serial_tx_byte('I');
+    ARTX_serial_tx_data(&isr->bank[b], sizeof(struct artx_monitor_cycles));
+    ARTX_serial_tx_string_pgm(isr->name);
+    ARTX_serial_tx_byte('\0');
+#endif
+    reset_cycles(&isr->bank[b]);
   }
 
 #if ARTX_ENABLE_SERIAL
+  ARTX_serial_tx_byte('K');
+  ARTX_serial_tx_data(&artx_monitor_kernel.bank[b], sizeof(struct artx_monitor_cycles));
+#endif
+  reset_cycles(&artx_monitor_kernel.bank[b]);
+
+#if ARTX_ENABLE_SERIAL
+#if ARTX_ENABLE_CLI_PROFILE
+  uint8_t sites = 0;
+
+  for (uint8_t i = 0; i < ARTX_CLI_SITES; i++)
+  {
+    if (artx_monitor_cli[i].site)
+    {
+      sites++;
+    }
+  }
+
+  ARTX_serial_tx_byte('C');
+  ARTX_serial_tx_byte(sites);
+  ARTX_serial_tx_data(&artx_monitor_cli_other, sizeof(artx_monitor_cli_other));
+
+  for (uint8_t i = 0; i < ARTX_CLI_SITES; i++)
+  {
+    if (artx_monitor_cli[i].site)
+    {
+      static struct artx_monitor_cli cli;
+
+      /* take a consistent copy without opening a window of our own */
+      asm volatile ("cli");
+      cli = artx_monitor_cli[i];
+      asm volatile ("sei");
+
+      ARTX_serial_tx_data(&cli, sizeof(struct artx_monitor_cli));
+    }
+  }
+#endif
+
+#if ARTX_ENABLE_PROFILE
+  register struct artx_monitor_profile *prof = &artx_monitor_prof[b];
+  uint8_t used = 0;
+
+  for (uint8_t i = 0; i < ARTX_PROFILE_SIZE; i++)
+  {
+    if (prof->sample[i].count)
+    {
+      used++;
+    }
+  }
+
+  ARTX_serial_tx_byte('P');
+  ARTX_serial_tx_byte(used);
+  ARTX_serial_tx_data(&prof->other, sizeof(prof->other));
+
+  for (uint8_t i = 0; i < ARTX_PROFILE_SIZE; i++)
+  {
+    if (prof->sample[i].count)
+    {
+      ARTX_serial_tx_data(&prof->sample[i], sizeof(struct artx_monitor_sample));
+      prof->sample[i].count = 0;
+    }
+  }
+
+  prof->other = 0;
+#endif
+
   ARTX_serial_tx_byte('E');
 #endif
+
+  artx_monitor_ctl.intervals[b] = 0;
+  artx_monitor_ctl.transmit_request = 0;
+}
+
+#if ARTX_ENABLE_CLI_PROFILE
+
+/**
+ *  Begin interrupt disabled window
+ *
+ *  \internal
+ *
+ *  This routine is called right after interrupts have been disabled
+ *  and records the start of the window.
+ *
+ *  \param site                  Address where the window starts.
+ */
+
+void artx_cli_begin(uint16_t site)
+{
+  artx_cli_start = artx_TIMER_REG;
+  artx_cli_site = site;
+}
+
+/**
+ *  End interrupt disabled window
+ *
+ *  \internal
+ *
+ *  This routine is called right before interrupts are enabled and
+ *  adds the duration of the current window, if any, to the statistics
+ *  of the site that started it. The window may span a wrap of the tick
+ *  timer, as the tick cannot be serviced while interrupts are disabled.
+ */
+
+void artx_cli_end(void)
+{
+  artx_TIMER_TYPE now = artx_TIMER_REG;
+  uint16_t site = artx_cli_site;
+
+  if (site == 0)
+  {
+    return;
+  }
+
+  artx_cli_site = 0;
+
+  uint16_t duration = now - artx_cli_start;
+
+  if (now < artx_cli_start)
+  {
+#ifdef artx_CUR_TIMER_TOP
+    duration += artx_CUR_TIMER_TOP;
+#else
+    duration += artx_TIMER_TOP;
+#endif
+  }
+
+  uint8_t slot = (uint8_t) site ^ (uint8_t) (site >> 8);
+
+  for (uint8_t probe = 4; probe--; slot++)
+  {
+    register struct artx_monitor_cli *cli = &artx_monitor_cli[slot & (ARTX_CLI_SITES - 1)];
+
+    if (cli->site == site || cli->site == 0)
+    {
+      uint8_t bin = 0;
+
+      cli->site = site;
+
+      if (duration > cli->max)
+      {
+        cli->max = duration;
+      }
+
+      for (uint16_t d = duration >> 4; d && bin < artx_CLI_BINS - 1; d >>= 1)
+      {
+        bin++;
+      }
+
+      if (cli->bins[bin] < UINT16_MAX)
+      {
+        cli->bins[bin]++;
+      }
+
+      return;
+    }
+  }
+
+  if (artx_monitor_cli_other < UINT16_MAX)
+  {
+    artx_monitor_cli_other++;
+  }
+}
+
+#endif
+
+#if ARTX_ENABLE_STATS
+
+/**
+ *  Get task statistics
+ *
+ *  This routine copies the statistics of a task from the last
+ *  complete monitoring interval. All values are zero until the
+ *  first monitoring interval has completed.
+ *
+ *  Calls to this routine must be locked.
+ *
+ *  \param tcb                   Pointer to the task control block.
+ *
+ *  \param stats                 Pointer to a buffer to store the
+ *                               statistics.
+ */
+
+void ARTX_stats_get_task(const struct artx_tcb *tcb, struct ARTX_task_stats *stats)
+{
+  *stats = tcb->mon.stats;
 }
 
+#endif
+
 /**
  *  Set monitoring interval
  *
  *  Use this routine to set the monitoring interval. The initial
  *  interval is 0, which means no monitoring data is sent. Data
- *  is updated for each task or routine at every second interval
- *  boundary.
+ *  is sent at every interval boundary for each task or routine
+ *  that has completed at least one run during the interval.
  *
  *  \param interval              Monitoring interval in ticks.
  */
@@ -0,0 +1,159 @@
+/*******************************************************************************
+*
+* ARTX sampling monitor
+*
+********************************************************************************
+*
+* ARTX - A realtime executive library for Atmel AVR microcontrollers
+*
+* Copyright (C) 2007-2015 Marcus Holland-Moritz.
+*
+* ARTX is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* ARTX is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with ARTX.  If not, see <http://www.gnu.org/licenses/>.
+*
+*******************************************************************************/
+
+/**
+ *  \file sampling.c
+ *  \brief Sampling monitor
+ */
+
+
+/*===== GLOBAL INCLUDES ======================================================*/
+
+#include <avr/io.h>
+
+
+/*===== LOCAL INCLUDES =======================================================*/
+
+#include "artx/monitor.h"
+#include "artx/serial.h"
+#include "artx/task.h"
+#include "artx/util.h"
+
+#if ARTX_ENABLE_SAMPLING
+
+
+/*===== DEFINES ==============================================================*/
+
+/*===== TYPEDEFS =============================================================*/
+
+/*===== STATIC FUNCTION PROTOTYPES ===========================================*/
+
+static void transmit_samples(char block, uint16_t *samples, PGM_P name);
+
+
+/*===== EXTERNAL VARIABLES ===================================================*/
+
+/*===== GLOBAL VARIABLES =====================================================*/
+
+/**
+ *  Sampling control data
+ *
+ *  \internal
+ */
+struct artx_sampling_control artx_sampling_ctl = {
+  .countdown = ARTX_SAMPLING_INTERVAL,
+  .seed = 1
+};
+
+
+/*===== STATIC VARIABLES =====================================================*/
+
+/**
+ *  ARTX sampling frame marker
+ *
+ *  \internal
+ *
+ *  This marker is sent at the beginning of each sampling frame to
+ *  synchronize the serial stream.
+ */
+static const char artx_sampling_marker[] PROGMEM = "ARTS";
+
+
+/*===== STATIC FUNCTIONS =====================================================*/
+
+/**
+ *  Transmit sample count
+ *
+ *  \internal
+ *
+ *  This routine transmits the sample count of a single task or
+ *  routine and resets it. The count is read and reset with
+ *  interrupts disabled, as it is updated by the sampling interrupt.
+ *
+ *  \param block                 Block type, 'T' or 'R'.
+ *
+ *  \param samples               Pointer to the sample count.
+ *
+ *  \param name                  Name of the task or routine.
+ */
+
+static void transmit_samples(char block, uint16_t *samples, PGM_P name)
+{
+  uint16_t count;
+
+  ARTX_disable_int();
+  count = *samples;
+  *samples = 0;
+  ARTX_enable_int();
+
+  ARTX_serial_tx_byte(block);
+  ARTX_serial_tx_data(&count, sizeof(count));
+  ARTX_serial_tx_string_pgm(name);
+  ARTX_serial_tx_byte('\0');
+}
+
+
+/*===== FUNCTIONS ============================================================*/
+
+/**
+ *  Transmit sample counts
+ *
+ *  \internal
+ *
+ *  This routine is called by the idle task after the sampling
+ *  interrupt has taken #ARTX_SAMPLING_INTERVAL samples and transmits
+ *  the sample counts of all tasks and routines. The counts keep being
+ *  updated during the transmission, so the host should relate them to
+ *  their sum rather than to the interval.
+ */
+
+void artx_sampling_transmit(void)
+{
+  struct artx_sampling_header header = {
+    .version = artx_SAMPLING_VERSION,
+    .hdr_size = sizeof(struct artx_sampling_header),
+    .interval = ARTX_SAMPLING_INTERVAL
+  };
+
+  ARTX_serial_tx_string_pgm(artx_sampling_marker);
+  ARTX_serial_tx_data(&header, sizeof(struct artx_sampling_header));
+
+  /* tasks may be linked and unlinked while we're transmitting */
+  for (register struct artx_tcb *tcb = artx_task_walk(0); tcb; tcb = artx_task_walk(tcb))
+  {
+    transmit_samples('T', &tcb->mon.samples, tcb->mon.name);
+
+#if ARTX_USE_MULTI_ROUT
+    for (register struct artx_rcb *rcb = tcb->rout; rcb; rcb = rcb->next)
+    {
+      transmit_samples('R', &rcb->mon.samples, rcb->mon.name);
+    }
+#endif
+  }
+
+  ARTX_serial_tx_byte('E');
+}
+
+#endif
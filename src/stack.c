@@ -0,0 +1,221 @@
+/*******************************************************************************
+*
+* ARTX stack usage checking
+*
+********************************************************************************
+*
+* ARTX - A realtime executive library for Atmel AVR microcontrollers
+*
+* Copyright (C) 2007-2015 Marcus Holland-Moritz.
+*
+* ARTX is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* ARTX is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with ARTX.  If not, see <http://www.gnu.org/licenses/>.
+*
+*******************************************************************************/
+
+/**
+ *  \file stack.c
+ *  \brief Stack usage checking
+ */
+
+
+/*===== GLOBAL INCLUDES ======================================================*/
+
+#include <stddef.h>
+
+
+/*===== LOCAL INCLUDES =======================================================*/
+
+#include "artx/stack.h"
+#include "artx/task.h"
+#include "artx/util.h"
+
+#if ARTX_ENABLE_MONITOR || ARTX_ENABLE_STACK_CHECK
+
+
+/*===== DEFINES ==============================================================*/
+
+/**
+ *  Stack sentinel
+ *
+ *  \internal
+ *
+ *  This byte is used to identify unused bytes on the stack.
+ */
+#define artx_STACK_SENTINEL 0xC3
+
+/**
+ *  Stack watermark of a task
+ *
+ *  \internal
+ *  \hideinitializer
+ *
+ *  With #ARTX_ENABLE_MONITOR, the watermark is part of the task's
+ *  monitoring info, so both share the same scan.
+ */
+#if ARTX_ENABLE_MONITOR
+# define artx_TCB_STACK(tcb)  (&(tcb)->mon.stack)
+#else
+# define artx_TCB_STACK(tcb)  (&(tcb)->stack)
+#endif
+
+
+/*===== TYPEDEFS =============================================================*/
+
+/*===== STATIC FUNCTION PROTOTYPES ===========================================*/
+
+/*===== EXTERNAL VARIABLES ===================================================*/
+
+#if ARTX_ENABLE_STACK_CHECK
+extern struct artx_tcb *artx_task_list;
+#endif
+
+
+/*===== GLOBAL VARIABLES =====================================================*/
+
+/*===== STATIC VARIABLES =====================================================*/
+
+/*===== STATIC FUNCTIONS =====================================================*/
+
+/*===== FUNCTIONS ============================================================*/
+
+/**
+ *  Initialize stack watermark
+ *
+ *  \internal
+ *
+ *  This routine fills the unused part of a task's stack with
+ *  sentinel bytes. It must be called before the task is run.
+ *
+ *  \param stk                   Pointer to stack watermark. The
+ *                               bottom of the stack must already
+ *                               be set.
+ *
+ *  \param size                  Number of bytes to fill.
+ */
+
+void artx_stack_init(struct artx_stack_mark *stk, uint16_t size)
+{
+  uint8_t *p = stk->base;
+
+  stk->mark = size;
+  stk->scan = 0;
+
+  while (size-- > 0)
+  {
+    *p++ = artx_STACK_SENTINEL;
+  }
+}
+
+/**
+ *  Update stack watermark
+ *
+ *  \internal
+ *
+ *  This routine scans up to #ARTX_STACK_SCAN_BUDGET bytes of a
+ *  task's stack below the watermark and lowers the watermark for
+ *  every byte that no longer holds the sentinel. The scan is locked,
+ *  so it can be used by the monitor and the application at the
+ *  same time.
+ *
+ *  \param stk                   Pointer to stack watermark.
+ *
+ *  \returns Number of bytes at the bottom of the stack that have
+ *           never been used, as far as known.
+ */
+
+uint16_t artx_stack_scan(struct artx_stack_mark *stk)
+{
+  uint16_t budget = ARTX_STACK_SCAN_BUDGET;
+
+  ARTX_lock();
+
+  uint16_t i = stk->scan;
+
+  if (i == 0)
+  {
+    i = stk->mark;
+  }
+
+  while (i > 0 && budget-- > 0)
+  {
+    if (stk->base[--i] != artx_STACK_SENTINEL)
+    {
+      stk->mark = i;
+    }
+  }
+
+  stk->scan = i;
+
+  uint16_t mark = stk->mark;
+
+  ARTX_unlock();
+
+  return mark;
+}
+
+#if ARTX_ENABLE_STACK_CHECK
+
+/**
+ *  Get free stack space of a task
+ *
+ *  This routine returns the number of bytes at the bottom of a task's
+ *  stack that have never been used. Each call only looks at a limited
+ *  number of bytes, so a drop in free stack space that isn't right
+ *  below the last known watermark may only be reported after a couple
+ *  of calls. The value never increases.
+ *
+ *  The returned value includes the few bytes the kernel reserves on
+ *  each stack, so a task is about to overflow its stack when this
+ *  approaches zero.
+ *
+ *  \param tcb                   Pointer to the task control block.
+ *
+ *  \returns Number of bytes that have never been used.
+ */
+
+uint16_t ARTX_stack_get_free(struct artx_tcb *tcb)
+{
+  return artx_stack_scan(artx_TCB_STACK(tcb));
+}
+
+/**
+ *  Check stacks of all tasks
+ *
+ *  This routine updates the stack watermark of each task and looks
+ *  for a task that has fewer than #ARTX_STACK_CHECK_MARGIN bytes of
+ *  its stack left. It is cheap enough to be called periodically from
+ *  a low priority task, e.g. to log the problem or to reset the device
+ *  before a stack overflow corrupts any data.
+ *
+ *  \returns Pointer to the control block of the first task that is
+ *           running low on stack space, or \c NULL if no such task
+ *           was found.
+ */
+
+struct artx_tcb *ARTX_stack_check(void)
+{
+  for (register struct artx_tcb *tcb = artx_task_list; tcb; tcb = tcb->next)
+  {
+    if (ARTX_stack_get_free(tcb) < ARTX_STACK_CHECK_MARGIN)
+    {
+      return tcb;
+    }
+  }
+
+  return NULL;
+}
+
+#endif
+
+#endif
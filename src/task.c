@@ -132,6 +132,7 @@
 
 #include <avr/io.h>
 #include <avr/interrupt.h>
+#include <avr/pgmspace.h>
 
 
 /*===== LOCAL INCLUDES =======================================================*/
@@ -141,6 +142,10 @@
 #include "artx/util.h"
 #include "artx/handy.h"
 #include "artx/monitor.h"
+#include "artx/stack.h"
+#include "artx/isr.h"
+#include "artx/trace.h"
+#include "artx/log.h"
 
 
 /*===== DEFINES ==============================================================*/
@@ -149,6 +154,43 @@
 
 #define artx_TICK_LENGTH_USEC  ((uint32_t) (((uint64_t) artx_USEC_ONE_SECOND*ARTX_TICK_DURATION*ARTX_TICK_PRESCALER + ARTX_CLOCK_FREQUENCY/2)/ARTX_CLOCK_FREQUENCY))
 
+/**
+ *  Track time spent in tasks
+ *
+ *  \internal
+ *  \hideinitializer
+ *
+ *  Nonzero if the kernel needs to know how much time has elapsed
+ *  since the last task switch.
+ */
+#define artx_USE_ELAPSED  (ARTX_ENABLE_MONITOR || ARTX_ENABLE_BUDGET)
+
+/**
+ *  Count kernel ticks
+ *
+ *  \internal
+ *  \hideinitializer
+ *
+ *  Nonzero if the kernel needs to maintain a tick counter.
+ */
+#define artx_USE_TICK_COUNT  (ARTX_USE_TASK_SUSPEND || ARTX_ENABLE_SPORADIC || \
+                              ARTX_USE_ABS_RELEASE)
+
+/**
+ *  Track changes to the task list
+ *
+ *  \internal
+ *  \hideinitializer
+ *
+ *  The monitor walks the task list with interrupts enabled, so it
+ *  needs to know when tasks have been linked or unlinked meanwhile.
+ */
+#if ARTX_ENABLE_MONITOR || ARTX_ENABLE_SAMPLING
+# define artx_TASK_LIST_CHANGED()    artx_task_list_gen++
+#else
+# define artx_TASK_LIST_CHANGED()    do { } while (0)
+#endif
+
 /**
  *  Check if a routine is currently enabled
  *
@@ -161,6 +203,172 @@
 # define artx_ROUT_IS_ENABLED(rcb)   1
 #endif
 
+/**
+ *  Difference of two schedules
+ *
+ *  \internal
+ *  \hideinitializer
+ *
+ *  Absolute schedules wrap around along with the tick count, so
+ *  they can only be compared by looking at the sign of their
+ *  difference.
+ */
+#define artx_SCHED_DIFF(a, b)        ((artx_sched_diff_type) ((a) - (b)))
+
+/**
+ *  Check if task has been released
+ *
+ *  \internal
+ *  \hideinitializer
+ */
+#if ARTX_USE_ABS_RELEASE
+# define artx_IS_RELEASED(tcb)       (artx_SCHED_DIFF(artx_tick_count, (tcb)->schedule) >= 0)
+#else
+# define artx_IS_RELEASED(tcb)       ((tcb)->schedule <= 0)
+#endif
+
+/**
+ *  Schedule for release after a number of ticks
+ *
+ *  \internal
+ *  \hideinitializer
+ *
+ *  Yields the schedule of a task that is to be released the given
+ *  number of ticks after the last tick.
+ */
+#if ARTX_USE_ABS_RELEASE
+# define artx_RELEASE_IN(ticks)      ((artx_sched_type) (artx_tick_count + (ticks)))
+#else
+# define artx_RELEASE_IN(ticks)      ((artx_sched_type) (ticks))
+#endif
+
+/**
+ *  Read schedule or interval from flash
+ *
+ *  \internal
+ *  \hideinitializer
+ */
+#if ARTX_USE_ABS_RELEASE
+# define artx_READ_SCHED(addr)       ((artx_sched_type) pgm_read_dword(addr))
+#elif ARTX_USE_SHORT_SCHEDULE
+# define artx_READ_SCHED(addr)       ((artx_sched_type) pgm_read_byte(addr))
+#else
+# define artx_READ_SCHED(addr)       ((artx_sched_type) pgm_read_word(addr))
+#endif
+
+/**
+ *  Access constant task data
+ *
+ *  \internal
+ *  \hideinitializer
+ *
+ *  With #ARTX_USE_ROM_TCB, these fields must be read from flash.
+ */
+#if ARTX_USE_ROM_TCB
+# define artx_TCB_ROUT(tcb)          ((void (*)(void)) pgm_read_word(&(tcb)->rom->rout))
+# define artx_TCB_INTERVAL(tcb)      artx_READ_SCHED(&(tcb)->rom->interval)
+# define artx_TCB_PRIORITY(tcb)      pgm_read_byte(&(tcb)->rom->priority)
+#else
+# define artx_TCB_ROUT(tcb)          ((tcb)->rout)
+# define artx_TCB_INTERVAL(tcb)      ((tcb)->interval)
+# define artx_TCB_PRIORITY(tcb)      ((tcb)->priority)
+#endif
+
+#if ARTX_USE_GPIOR
+# if !defined(GPIOR0) || (ARTX_ENABLE_MONITOR && (!defined(GPIOR1) || !defined(GPIOR2)))
+#  error "ARTX_USE_GPIOR is not supported on this device"
+# endif
+#endif
+
+/**
+ *  Check tick indicator
+ *
+ *  \internal
+ *  \hideinitializer
+ */
+#if ARTX_USE_GPIOR
+# define artx_IS_TICK()              (GPIOR0 & _BV(0))
+#else
+# define artx_IS_TICK()              artx_is_tick
+#endif
+
+/**
+ *  Operands for kernel state in I/O registers
+ *
+ *  \internal
+ *  \hideinitializer
+ *
+ *  Appended to inline assembly statements that access kernel state
+ *  kept in general purpose I/O registers. \c GPIOR1 and \c GPIOR2 are
+ *  only used with #ARTX_ENABLE_MONITOR, so they are only required on
+ *  the device in that case. Without #ARTX_USE_GPIOR, these statements
+ *  don't take any operands.
+ */
+#if ARTX_USE_GPIOR && ARTX_ENABLE_MONITOR
+# define artx_GPIOR_OPERANDS         : : [gpior0] "I" (_SFR_IO_ADDR(GPIOR0)),    \
+                                         [gpior1] "I" (_SFR_IO_ADDR(GPIOR1)),    \
+                                         [gpior2] "I" (_SFR_IO_ADDR(GPIOR2))
+#elif ARTX_USE_GPIOR
+# define artx_GPIOR_OPERANDS         : : [gpior0] "I" (_SFR_IO_ADDR(GPIOR0))
+#else
+# define artx_GPIOR_OPERANDS
+#endif
+
+/**
+ *  Read schedule table task mask
+ *
+ *  \internal
+ *  \hideinitializer
+ */
+#if ARTX_SCHED_TABLE
+# if ARTX_SCHED_TABLE_TASKS <= 8
+#  define artx_TT_READ_MASK(addr)    pgm_read_byte(addr)
+# elif ARTX_SCHED_TABLE_TASKS <= 16
+#  define artx_TT_READ_MASK(addr)    pgm_read_word(addr)
+# else
+#  define artx_TT_READ_MASK(addr)    pgm_read_dword(addr)
+# endif
+#endif
+
+#if ARTX_FIXED_REGS
+
+/**
+ *  Push/Pop Registers not reserved by #ARTX_FIXED_REGS
+ *
+ *  \internal
+ *  \hideinitializer
+ *
+ *  These macros push and pop the general purpose registers
+ *  just like the ones below, but the assembler skips all registers
+ *  from r2 up to r(#ARTX_FIXED_REGS + 1), as they're never used by
+ *  any task.
+ */
+#define artx_POP_R0_THRU_R29                                 \
+          "pop  r0 \n\tpop  r1 \n\t"                         \
+          ".irp r,2,3,4,5,6,7,8,9,10,11,12,13,14,15,16,17\n\t" \
+          ".if \\r >= 2 + " ARTX_STRINGIZE(ARTX_FIXED_REGS) "\n\t" \
+          "pop  r\\r\n\t"                                    \
+          ".endif\n\t"                                       \
+          ".endr\n\t"                                        \
+          "pop  r18\n\tpop  r19\n\t"                         \
+          "pop  r20\n\tpop  r21\n\tpop  r22\n\tpop  r23\n\t" \
+          "pop  r24\n\tpop  r25\n\tpop  r26\n\tpop  r27\n\t" \
+          "pop  r28\n\tpop  r29\n\t"
+
+#define artx_PUSH_R29_THRU_R0                                \
+                                  "push r29\n\tpush r28\n\t" \
+          "push r27\n\tpush r26\n\tpush r25\n\tpush r24\n\t" \
+          "push r23\n\tpush r22\n\tpush r21\n\tpush r20\n\t" \
+          "push r19\n\tpush r18\n\t"                         \
+          ".irp r,17,16,15,14,13,12,11,10,9,8,7,6,5,4,3,2\n\t" \
+          ".if \\r >= 2 + " ARTX_STRINGIZE(ARTX_FIXED_REGS) "\n\t" \
+          "push r\\r\n\t"                                    \
+          ".endif\n\t"                                       \
+          ".endr\n\t"                                        \
+          "push r1 \n\tpush r0 \n\t"
+
+#else /* !ARTX_FIXED_REGS */
+
 /**
  *  Pop General Purpose Registers
  *
@@ -203,10 +411,12 @@
           "push r7 \n\tpush r6 \n\tpush r5 \n\tpush r4 \n\t" \
           "push r3 \n\tpush r2 \n\tpush r1 \n\tpush r0 \n\t"
 
+#endif /* ARTX_FIXED_REGS */
+
 
 /*===== TYPEDEFS =============================================================*/
 
-#if ARTX_ENABLE_MONITOR || ARTX_ENABLE_TICK_SYNC || ARTX_ENABLE_TIME
+#if artx_USE_ELAPSED || ARTX_ENABLE_TICK_SYNC || ARTX_ENABLE_TIME
 
 /**
  *  Timer type
@@ -225,10 +435,68 @@ typedef artx_TIMER_TYPE artx_timer_type;
 
 /*===== STATIC FUNCTION PROTOTYPES ===========================================*/
 
-#if ARTX_ENABLE_MONITOR
+#if artx_USE_ELAPSED
 static artx_timer_type artx_elapsed(void);
 #endif
 
+#if ARTX_ENABLE_MONITOR
+static void artx_elapsed_skip(artx_timer_type cycles);
+static artx_timer_type artx_elapsed_restart(void);
+static void artx_monitor_charge(struct artx_monitor_cycles *cyc, artx_timer_type cycles);
+#endif
+
+#if ARTX_ENABLE_HISTOGRAM
+static void artx_monitor_histogram(uint16_t *hist, uint32_t cycles);
+#endif
+
+#if ARTX_ENABLE_LATENCY
+static uint32_t artx_release_latency(struct artx_tcb *tcb);
+static void artx_monitor_latency(struct artx_monitor_task *mon, uint32_t response);
+#endif
+
+#if ARTX_ENABLE_PROFILE
+static void artx_profile_sample(void);
+#endif
+
+#if ARTX_ENABLE_SAMPLING
+static void artx_sampling_next(void);
+#endif
+
+#if ARTX_ENABLE_BUDGET
+static void artx_budget_charge(struct artx_tcb *tcb, artx_timer_type elapsed);
+#endif
+
+#if ARTX_ENABLE_SPORADIC
+static void artx_sporadic_replenish(struct artx_tcb *tcb);
+static void artx_sporadic_post(struct artx_tcb *tcb);
+static void artx_sporadic_defer(struct artx_tcb *tcb);
+static void artx_sporadic_arm(struct artx_tcb *tcb);
+static void artx_sporadic_complete(struct artx_tcb *tcb);
+#endif
+
+#if ARTX_SCHED_EDF
+static void artx_edf_insert(struct artx_tcb *tcb);
+static uint8_t artx_edf_remove(struct artx_tcb *tcb);
+#endif
+
+#if ARTX_SCHED_TABLE
+static void artx_tt_release(void);
+#endif
+
+#if ARTX_ENABLE_MODES
+static void artx_mode_apply(void);
+# if ARTX_USE_TASK_SUSPEND
+static uint8_t artx_mode_has_task(const struct artx_mode *mode, const struct artx_tcb *tcb);
+# endif
+#endif
+
+static void artx_task_setup(struct artx_tcb *tcb);
+static void artx_task_link(struct artx_tcb *tcb);
+
+#if ARTX_USE_TASK_SUSPEND || ARTX_TASK_POOL_SIZE || ARTX_ENABLE_SPORADIC
+static void artx_task_unlink(struct artx_tcb *tcb);
+#endif
+
 static artxNORETURN artxNAKED void artx_run_task(void);
 
 static artxNEVERINLINE artxNAKED void artx_yield(void); // TODO: why is this naked?
@@ -252,11 +520,25 @@ static artxALWAYSINLINE inline void artx_push_context(void);
  *  kept sorted by priority. The first element is the task with the
  *  highest priority, the last element is the idle task.
  */
-#if !ARTX_ENABLE_MONITOR
+#if !ARTX_ENABLE_STACK_CHECK
 static
 #endif
        struct artx_tcb *artx_task_list = 0;
 
+#if ARTX_ENABLE_MONITOR || ARTX_ENABLE_SAMPLING
+
+/**
+ *  Task list generation
+ *
+ *  \internal
+ *
+ *  Incremented whenever the task list is changed, see
+ *  artx_task_walk().
+ */
+static uint8_t artx_task_list_gen;
+
+#endif
+
 /**
  *  Task control block of the currently running task
  *
@@ -264,6 +546,8 @@ static
  */
 static struct artx_tcb * volatile artx_current_tcb;
 
+#if !ARTX_USE_GPIOR
+
 /**
  *  Tick indicator
  *
@@ -271,10 +555,144 @@ static struct artx_tcb * volatile artx_current_tcb;
  *
  *  This variable, when set to a nonzero value, indicates that the
  *  scheduler has been triggered by the tick and not by a yielding
- *  task.
+ *  task. With #ARTX_USE_GPIOR, bit 0 of \c GPIOR0 is used instead.
  */
 static volatile uint8_t artx_is_tick;
 
+#endif
+
+#if ARTX_SCHED_EDF
+
+/**
+ *  EDF ready list
+ *
+ *  \internal
+ *
+ *  Pointer to the first element of the list of released tasks. The
+ *  list is kept sorted by deadline, tasks with the same deadline are
+ *  sorted by priority. As the schedule of all tasks is decremented
+ *  with each tick, the order of the list never changes over time.
+ *  The idle task is never part of this list.
+ */
+static struct artx_tcb *artx_edf_list;
+
+#endif // ARTX_SCHED_EDF
+
+#if ARTX_SCHED_EDF || ARTX_ENABLE_MODES
+
+/**
+ *  Idle task
+ *
+ *  \internal
+ *
+ *  Pointer to the idle task, which is run whenever the EDF ready
+ *  list is empty. The idle task is also kept in the task list when
+ *  switching operating modes.
+ */
+static struct artx_tcb *artx_idle_tcb;
+
+#endif
+
+#if ARTX_ENABLE_MODES
+
+/**
+ *  Current operating mode
+ *
+ *  \internal
+ *
+ *  Pointer to the currently active operating mode, or null if
+ *  no mode has been selected yet.
+ */
+#if !ARTX_ENABLE_MONITOR
+static
+#endif
+       const struct artx_mode *artx_current_mode;
+
+/**
+ *  Requested operating mode
+ *
+ *  \internal
+ *
+ *  Pointer to the operating mode that will be activated with the
+ *  next tick, or null if no mode switch is pending.
+ */
+static const struct artx_mode * volatile artx_mode_request;
+
+#endif // ARTX_ENABLE_MODES
+
+#if ARTX_SCHED_TABLE
+
+/**
+ *  Next schedule table entry
+ *
+ *  \internal
+ *
+ *  Pointer to the schedule table entry that will be processed
+ *  when #artx_tt_delay drops to zero.
+ */
+static const struct artx_tt_entry *artx_tt_next = artx_tt_table;
+
+/**
+ *  Ticks until next schedule table entry
+ *
+ *  \internal
+ *
+ *  This counter is decremented with each tick. The first table
+ *  entry is processed with the very first tick.
+ */
+static uint16_t artx_tt_delay = 1;
+
+#endif // ARTX_SCHED_TABLE
+
+#if ARTX_TASK_POOL_SIZE
+
+/**
+ *  Task pool control blocks
+ *
+ *  \internal
+ *
+ *  Task control blocks of the task pool. A priority of zero marks
+ *  an unused entry, as no user task or idle task can have that
+ *  priority.
+ */
+static struct artx_tcb artx_pool_tcb[ARTX_TASK_POOL_SIZE];
+
+/**
+ *  Task pool stacks
+ *
+ *  \internal
+ */
+static uint8_t artx_pool_stack[ARTX_TASK_POOL_SIZE]
+                              [ARTX_TASK_POOL_STACK_SIZE + artx_STACK_OVERHEAD];
+
+#if ARTX_ENABLE_MONITOR || ARTX_ENABLE_SAMPLING
+/**
+ *  Task pool name
+ *
+ *  \internal
+ *
+ *  The name reported by the monitor for all tasks in the pool.
+ */
+static const char artx_pool_name[] PROGMEM = "pool";
+#endif
+
+#endif // ARTX_TASK_POOL_SIZE
+
+#if artx_USE_TICK_COUNT
+
+/**
+ *  Tick counter
+ *
+ *  \internal
+ *
+ *  Number of ticks since the kernel was started. This is used to
+ *  restore the release phase of resumed tasks, to replenish
+ *  sporadic servers and as the time base for absolute releases.
+ */
+static uint32_t artx_tick_count;
+
+#endif
+
 #if ARTX_ENABLE_TIME
 /**
  *  Tick indicator
@@ -290,7 +708,7 @@ static uint32_t artx_us_tmp;
 static uint32_t artx_s_time;
 #endif
 
-#if ARTX_ENABLE_MONITOR
+#if artx_USE_ELAPSED
 
 /**
  *  Last timer/counter value
@@ -304,8 +722,14 @@ static uint32_t artx_s_time;
  */
 static volatile artx_timer_type artx_last_timer;
 
+#endif
+
+#if ARTX_ENABLE_MONITOR
+
+#if !ARTX_USE_GPIOR
 static uint8_t artxASMONLY artx_SREG; //!< SREG temporary storage \internal
 static uint8_t artxASMONLY artx_R31;  //!< R31 temporary storage \internal
+#endif
 static uint8_t artxASMONLY artx_R30;  //!< R30 temporary storage \internal
 static uint8_t artxASMONLY artx_R29;  //!< R29 temporary storage \internal
 static uint8_t artxASMONLY artx_R28;  //!< R28 temporary storage \internal
@@ -314,7 +738,7 @@ static uint8_t artxASMONLY artx_R28;  //!< R28 temporary storage \internal
 
 #if ARTX_ENABLE_TICK_SYNC
 
-#if ARTX_ENABLE_MONITOR
+#if artx_USE_ELAPSED
 /**
  *  Last timer top value
  *
@@ -361,7 +785,7 @@ static struct ARTX_sync_status artx_sync_status;
 
 /*===== STATIC FUNCTIONS =====================================================*/
 
-#if ARTX_ENABLE_MONITOR
+#if artx_USE_ELAPSED
 
 /**
  *  Get time since last task switch
@@ -394,29 +818,900 @@ static artx_timer_type artx_elapsed(void)
 }
 #endif
 
+#if ARTX_ENABLE_MONITOR
+
 /**
- *  Save a task's context
+ *  Skip time
  *
  *  \internal
  *
- *  This routine fully saves a task's context to its stack and
- *  control block.
+ *  This routine moves the point in time that artx_elapsed() refers
+ *  to ahead, so the skipped time won't be returned by artx_elapsed()
+ *  anymore.
+ *
+ *  \param cycles                Time to skip in units of the timer
+ *                               used as the tick source.
  */
 
-static inline void artx_push_context(void)
+static void artx_elapsed_skip(artx_timer_type cycles)
 {
-  asm volatile (
-
-    "in    r31, __SREG__             \n\t" /* get SREG               */
-
-#if ARTX_ENABLE_MONITOR
-    "sts   artx_SREG, r31            \n\t" /* save SREG              */
+#if ARTX_ENABLE_TICK_SYNC
+  uint32_t top = artx_last_timer_top;
+#else
+  uint32_t top = artx_TIMER_TOP;
+#endif
+  uint32_t last = (uint32_t) artx_last_timer + cycles;
 
-    "sts   artx_R30, r30             \n\t" /* save R30               */
-    "sts   artx_R29, r29             \n\t" /* save R29               */
+  if (last >= top)
+  {
+    last -= top;
+  }
 
-    "lds   r30, artx_current_tcb     \n\t" /* load pointer to SP     */
-    "lds   r31, artx_current_tcb + 1 \n\t" /*   buffer into Z reg    */
+  artx_last_timer = last;
+}
+
+/**
+ *  Get time since last accounting point and restart
+ *
+ *  \internal
+ *
+ *  This routine works like artx_elapsed(), but also moves the
+ *  accounting point to the current time. This way, every cycle
+ *  is accounted exactly once, either to a task, to an interrupt
+ *  service routine or to the kernel.
+ *
+ *  \returns Time since last accounting point in units of the timer
+ *           used as the tick source.
+ */
+
+static artx_timer_type artx_elapsed_restart(void)
+{
+  artx_timer_type elapsed = artx_elapsed();
+
+  artx_elapsed_skip(elapsed);
+
+  return elapsed;
+}
+
+/**
+ *  Charge cycles
+ *
+ *  \internal
+ *
+ *  This routine adds the cycles of a single run to the cycle
+ *  accounting info. The caller is responsible for selecting
+ *  the bank that is currently collecting.
+ *
+ *  \param cyc                   Pointer to cycle accounting info.
+ *
+ *  \param cycles                Cycles spent in this run.
+ */
+
+static void artx_monitor_charge(struct artx_monitor_cycles *cyc, artx_timer_type cycles)
+{
+  cyc->run_counter++;
+  cyc->total_cycles += cycles;
+
+  if (cycles > cyc->peak_cycles)
+  {
+    cyc->peak_cycles = cycles;
+  }
+}
+
+#if ARTX_ENABLE_HISTOGRAM
+
+/**
+ *  Update execution time histogram
+ *
+ *  \internal
+ *
+ *  This routine adds a single run of a task or routine to its
+ *  execution time histogram.
+ *
+ *  \param hist                  Pointer to histogram bins.
+ *
+ *  \param cycles                Cycles spent in this run.
+ */
+
+static void artx_monitor_histogram(uint16_t *hist, uint32_t cycles)
+{
+  uint8_t bin = 0;
+
+  for (cycles >>= ARTX_HISTOGRAM_SHIFT; cycles && bin < ARTX_HISTOGRAM_BINS - 1; cycles >>= 1)
+  {
+    bin++;
+  }
+
+  if (hist[bin] < UINT16_MAX)
+  {
+    hist[bin]++;
+  }
+}
+
+#endif
+
+#if ARTX_ENABLE_LATENCY
+
+/**
+ *  Get time since release
+ *
+ *  \internal
+ *
+ *  This routine returns the time that has elapsed since the tick
+ *  at which a task has been released. The number of ticks since
+ *  the release is derived from the task's schedule, which keeps
+ *  being decremented after the release.
+ *
+ *  Calls to this routine must be locked.
+ *
+ *  \param tcb                   Pointer to the task control block.
+ *
+ *  \returns Time since release in units of the timer used as the
+ *           tick source.
+ */
+
+static uint32_t artx_release_latency(struct artx_tcb *tcb)
+{
+  uint32_t ticks = 0;
+
+  if (artxLIKELY(artx_IS_RELEASED(tcb)))
+  {
+#if ARTX_USE_ABS_RELEASE
+    ticks = artx_tick_count - tcb->schedule;
+#else
+    ticks = -tcb->schedule;
+#endif
+  }
+
+  return ticks*artx_TIMER_TOP + artx_TIMER_REG;
+}
+
+/**
+ *  Update release latency statistics
+ *
+ *  \internal
+ *
+ *  This routine adds a completed run of a task to its release
+ *  latency statistics.
+ *
+ *  \param mon                   Pointer to task monitoring data.
+ *
+ *  \param response              Response time of this run.
+ */
+
+static void artx_monitor_latency(struct artx_monitor_task *mon, uint32_t response)
+{
+  register struct artx_monitor_latency *lat = &mon->lat[artx_monitor_ctl.bank];
+  uint32_t start = mon->start_latency;
+
+  if (lat->count++ == 0)
+  {
+    lat->start_min = lat->start_max = lat->start_total = start;
+    lat->resp_min = lat->resp_max = lat->resp_total = response;
+    return;
+  }
+
+  if (start < lat->start_min)
+  {
+    lat->start_min = start;
+  }
+
+  if (start > lat->start_max)
+  {
+    lat->start_max = start;
+  }
+
+  if (response < lat->resp_min)
+  {
+    lat->resp_min = response;
+  }
+
+  if (response > lat->resp_max)
+  {
+    lat->resp_max = response;
+  }
+
+  lat->start_total += start;
+  lat->resp_total += response;
+}
+
+#endif
+
+#endif // ARTX_ENABLE_MONITOR
+
+#if ARTX_ENABLE_PROFILE
+
+/**
+ *  Sample program counter
+ *
+ *  \internal
+ *
+ *  This routine is called by the tick and adds the address where
+ *  the current task was interrupted to the program counter histogram.
+ *  With #ARTX_ENABLE_MONITOR, the task's stack pointer is saved right
+ *  below the return address pushed by the interrupt, so it's easy to
+ *  find. The histogram is a small hash table with linear probing.
+ *  If no slot is found within a few probes, the sample is counted
+ *  as dropped.
+ */
+
+static void artx_profile_sample(void)
+{
+  const uint8_t *sp = (const uint8_t *) artx_current_tcb->sp;
+  uint16_t pc = ((uint16_t) sp[1] << 8) | sp[2];
+  register struct artx_monitor_profile *prof = &artx_monitor_prof[artx_monitor_ctl.bank];
+  uint8_t slot = (uint8_t) pc ^ (uint8_t) (pc >> 8);
+
+  for (uint8_t probe = 4; probe--; slot++)
+  {
+    register struct artx_monitor_sample *s = &prof->sample[slot & (ARTX_PROFILE_SIZE - 1)];
+
+    if (s->pc == pc || s->count == 0)
+    {
+      s->pc = pc;
+      s->count++;
+      return;
+    }
+  }
+
+  prof->other++;
+}
+
+#endif // ARTX_ENABLE_PROFILE
+
+#if ARTX_ENABLE_SAMPLING
+
+/**
+ *  Set next sample point
+ *
+ *  \internal
+ *
+ *  This routine is called by the tick and sets the point within the
+ *  current tick at which the sampling interrupt will fire. The point
+ *  is taken from a 16-bit LFSR and scaled to the tick duration, so
+ *  that samples are not synchronized to task releases. Sample points
+ *  that lie before the end of the tick processing are skipped.
+ */
+
+static void artx_sampling_next(void)
+{
+  uint16_t seed = artx_sampling_ctl.seed;
+
+  seed = (seed >> 1) ^ (-(seed & 1) & 0xB400u);
+  artx_sampling_ctl.seed = seed;
+
+  artx_SAMPLE_REG = ((uint32_t) seed*artx_TIMER_TOP) >> 16;
+}
+
+#endif // ARTX_ENABLE_SAMPLING
+
+/**
+ *  Link task into task list
+ *
+ *  \internal
+ *
+ *  This routine inserts a task into the task list, keeping the
+ *  list sorted by priority.
+ *
+ *  \param tcb                   Pointer to the task control block.
+ */
+
+static void artx_task_link(struct artx_tcb *tcb)
+{
+  struct artx_tcb **pp = &artx_task_list;
+
+  while (*pp && artx_TCB_PRIORITY(tcb) >= artx_TCB_PRIORITY(*pp))
+  {
+    pp = &(*pp)->next;
+  }
+
+  tcb->next = *pp;
+  *pp = tcb;
+
+  artx_TASK_LIST_CHANGED();
+}
+
+#if ARTX_USE_TASK_SUSPEND || ARTX_TASK_POOL_SIZE || ARTX_ENABLE_SPORADIC
+
+/**
+ *  Unlink task from task list
+ *
+ *  \internal
+ *
+ *  This routine removes a task from the task list. It is safe
+ *  to call this routine for tasks that are not in the list.
+ *
+ *  Calls to this routine must be locked.
+ *
+ *  \param tcb                   Pointer to the task control block.
+ */
+
+static void artx_task_unlink(struct artx_tcb *tcb)
+{
+  struct artx_tcb **pp = &artx_task_list;
+
+  while (*pp)
+  {
+    if (*pp == tcb)
+    {
+      *pp = tcb->next;
+      artx_TASK_LIST_CHANGED();
+      break;
+    }
+
+    pp = &(*pp)->next;
+  }
+}
+
+#endif // ARTX_USE_TASK_SUSPEND || ARTX_TASK_POOL_SIZE || ARTX_ENABLE_SPORADIC
+
+/**
+ *  Set up task stack
+ *
+ *  \internal
+ *
+ *  This routine initializes the task's stack by simulating a
+ *  context push, so the task will start in artx_run_task() when
+ *  it is scheduled for the first time.
+ *
+ *  \param tcb                   Pointer to the task control block.
+ */
+
+static void artx_task_setup(struct artx_tcb *tcb)
+{
+#if ARTX_ENABLE_MONITOR
+  artx_monitor_task_init(&tcb->mon);
+#elif ARTX_ENABLE_STACK_CHECK
+  /* everything up to the initial context is still unused */
+  artx_stack_init(&tcb->stack, (uint8_t *) tcb->sp - tcb->stack.base + 1);
+#endif
+
+  uint8_t *sp = (uint8_t *) tcb->sp;
+  uint16_t raddr = (uint16_t) &artx_run_task;
+
+  /* initialize stack by simulating a context push */
+
+  *sp-- = raddr & 0xFF;    /* return address low byte   */
+  *sp-- = raddr >> 8;      /* return address high byte  */
+
+#if ARTX_ENABLE_MONITOR
+  /* switch from user stack to context stack */
+  tcb->sp = (uint16_t) sp;
+
+  sp = (uint8_t *) tcb->sp_cxt;
+#endif
+
+  for (uint8_t r = artx_CONTEXT_SIZE; r--; )
+  {
+    *sp-- = 0;             /* R31, SREG, R30 .. R0      */
+  }
+
+#if ARTX_ENABLE_MONITOR
+  tcb->sp_cxt = (uint16_t) sp;
+#else
+  tcb->sp = (uint16_t) sp;
+#endif
+}
+
+#if ARTX_SCHED_EDF
+
+/**
+ *  Insert task into EDF ready list
+ *
+ *  \internal
+ *
+ *  This routine inserts a released task into the EDF ready list.
+ *  The absolute deadline of the task is the end of its current
+ *  interval. Tasks with the same deadline are ordered by priority.
+ *
+ *  Calls to this routine must be locked.
+ *
+ *  \param tcb                   Pointer to the task control block.
+ */
+
+static void artx_edf_insert(struct artx_tcb *tcb)
+{
+  artx_sched_type deadline = tcb->schedule + artx_TCB_INTERVAL(tcb);
+  struct artx_tcb **pp = &artx_edf_list;
+
+  while (*pp)
+  {
+    artx_sched_type d = (*pp)->schedule + artx_TCB_INTERVAL(*pp);
+    artx_sched_diff_type diff = artx_SCHED_DIFF(d, deadline);
+
+    if (diff > 0 || (diff == 0 && artx_TCB_PRIORITY(*pp) > artx_TCB_PRIORITY(tcb)))
+    {
+      break;
+    }
+
+    pp = &(*pp)->edf_next;
+  }
+
+  tcb->edf_next = *pp;
+  *pp = tcb;
+}
+
+/**
+ *  Remove task from EDF ready list
+ *
+ *  \internal
+ *
+ *  This routine removes a task from the EDF ready list. It is safe
+ *  to call this routine for tasks that are not in the list.
+ *
+ *  Calls to this routine must be locked.
+ *
+ *  \param tcb                   Pointer to the task control block.
+ *
+ *  \returns Non-zero if the task was in the list.
+ */
+
+static uint8_t artx_edf_remove(struct artx_tcb *tcb)
+{
+  struct artx_tcb **pp = &artx_edf_list;
+
+  while (*pp)
+  {
+    if (*pp == tcb)
+    {
+      *pp = tcb->edf_next;
+      return 1;
+    }
+
+    pp = &(*pp)->edf_next;
+  }
+
+  return 0;
+}
+
+#endif // ARTX_SCHED_EDF
+
+#if ARTX_SCHED_TABLE
+
+/**
+ *  Process next schedule table entry
+ *
+ *  \internal
+ *
+ *  This routine releases all tasks marked in the next entry of
+ *  the static schedule table and advances to the following entry,
+ *  wrapping around at the end of the hyperperiod.
+ *
+ *  Releasing a task moves its schedule back by one interval, so a
+ *  task that has not completed before its next release will still
+ *  be run once for each release, just like with the default tick
+ *  handling.
+ *
+ *  Calls to this routine must be locked.
+ */
+
+static void artx_tt_release(void)
+{
+  const struct artx_tt_entry *entry = artx_tt_next;
+  artx_tt_mask_type mask = artx_TT_READ_MASK(&entry->mask);
+
+  for (struct artx_tcb * const *pp = artx_tt_tasks; mask; mask >>= 1, pp++)
+  {
+    if (mask & 1)
+    {
+      register struct artx_tcb *tcb = (struct artx_tcb *) pgm_read_word(pp);
+
+      artx_sched_type interval = artx_TCB_INTERVAL(tcb);
+
+      if (artxLIKELY(tcb->schedule >= artx_SCHED_MIN + interval))
+      {
+        tcb->schedule -= interval;
+      }
+
+      artx_TRACE(artx_TE_RELEASE, tcb);
+    }
+  }
+
+  artx_tt_delay = pgm_read_word(&entry->delay);
+
+  if (pgm_read_word(&(++entry)->delay) == 0)
+  {
+    entry = artx_tt_table + pgm_read_word(&artx_tt_loop);
+  }
+
+  artx_tt_next = entry;
+}
+
+#endif // ARTX_SCHED_TABLE
+
+#if ARTX_ENABLE_MODES
+
+#if ARTX_USE_TASK_SUSPEND
+
+/**
+ *  Check if a task is part of an operating mode
+ *
+ *  \internal
+ *
+ *  \param mode                  Pointer to the operating mode.
+ *
+ *  \param tcb                   Pointer to the task control block.
+ *
+ *  \returns Non-zero if the task is part of the mode.
+ */
+
+static uint8_t artx_mode_has_task(const struct artx_mode *mode, const struct artx_tcb *tcb)
+{
+  const struct artx_mode_task *mt = (const struct artx_mode_task *) pgm_read_word(&mode->tasks);
+
+  for (uint8_t count = pgm_read_byte(&mode->count); count > 0; count--, mt++)
+  {
+    if ((const struct artx_tcb *) pgm_read_word(&mt->tcb) == tcb)
+    {
+      return 1;
+    }
+  }
+
+  return 0;
+}
+
+#endif
+
+/**
+ *  Activate requested operating mode
+ *
+ *  \internal
+ *
+ *  This routine replaces the task list with the tasks of the
+ *  requested operating mode plus the idle task. The interval of
+ *  each task is set according to the mode, and each task will be
+ *  released \e offset ticks after the current tick.
+ *
+ *  Tasks that are no longer part of the task list are marked as
+ *  inactive with #ARTX_USE_TASK_SUSPEND and keep their saved
+ *  context. If such a task was preempted, it will continue where it
+ *  left off once it becomes active again. Tasks created from the task
+ *  pool are returned to the pool.
+ *
+ *  Calls to this routine must be locked.
+ */
+
+static void artx_mode_apply(void)
+{
+  const struct artx_mode *mode = artx_mode_request;
+  const struct artx_mode_task *mt = (const struct artx_mode_task *) pgm_read_word(&mode->tasks);
+  struct artx_tcb *last = 0;
+
+#if ARTX_USE_TASK_SUSPEND
+  /* tasks that are part of the new mode will be activated below */
+  for (register struct artx_tcb *tcb = artx_task_list; tcb != artx_idle_tcb; tcb = tcb->next)
+  {
+    tcb->state = ARTX_TS_INACTIVE;
+  }
+#endif
+
+#if ARTX_TASK_POOL_SIZE
+  /*
+   *  Pool tasks cannot be part of any mode, so they are returned to
+   *  the pool. Just like in ARTX_task_exit(), interrupts remain
+   *  disabled until we've left the current task's stack.
+   */
+  for (uint8_t i = 0; i < ARTX_TASK_POOL_SIZE; i++)
+  {
+    artx_pool_tcb[i].priority = 0;
+  }
+#endif
+
+  artx_idle_tcb->next = 0;
+  artx_task_list = artx_idle_tcb;
+  artx_TASK_LIST_CHANGED();
+
+  for (uint8_t count = pgm_read_byte(&mode->count); count > 0; count--, mt++)
+  {
+    register struct artx_tcb *tcb = (struct artx_tcb *) pgm_read_word(&mt->tcb);
+    struct artx_tcb **pp = &artx_task_list;
+
+    tcb->interval = artx_READ_SCHED(&mt->interval);
+#if ARTX_USE_ABS_RELEASE
+    tcb->schedule = artx_tick_count + artx_READ_SCHED(&mt->offset);
+#else
+    tcb->schedule = artx_READ_SCHED(&mt->offset) + 1;
+#endif
+#if ARTX_USE_TASK_SUSPEND
+    tcb->state = ARTX_TS_ACTIVE;
+#endif
+
+    /* tasks are usually listed by priority, so just append */
+    if (artxLIKELY(last && last->next == artx_idle_tcb && tcb->priority >= last->priority))
+    {
+      pp = &last->next;
+    }
+    else
+    {
+      while (tcb->priority >= (*pp)->priority)
+      {
+        pp = &(*pp)->next;
+      }
+    }
+
+    tcb->next = *pp;
+    *pp = tcb;
+    last = tcb;
+  }
+
+#if ARTX_SCHED_EDF
+  /* the schedules of all tasks have just been reset */
+  artx_edf_list = 0;
+#endif
+
+  artx_current_mode = mode;
+  artx_mode_request = 0;
+}
+
+#endif // ARTX_ENABLE_MODES
+
+#if ARTX_ENABLE_BUDGET
+
+/**
+ *  Charge execution time against task budget
+ *
+ *  \internal
+ *
+ *  This routine is called by the tick for the task that has been
+ *  interrupted. If the task has a budget and has used it up, it is
+ *  deferred until its next release. This is done by consuming the
+ *  current release just as if the task had completed, so the rest
+ *  of the task's work will be done using the next release.
+ *
+ *  Calls to this routine must be locked.
+ *
+ *  \param tcb                   Pointer to the task control block.
+ *
+ *  \param elapsed               Time since the last task switch.
+ */
+
+static void artx_budget_charge(struct artx_tcb *tcb, artx_timer_type elapsed)
+{
+  if (tcb->budget == 0)
+  {
+    return;
+  }
+
+#if ARTX_ENABLE_SPORADIC
+  if (tcb->sporadic)
+  {
+    artx_sporadic_replenish(tcb);
+    tcb->consumed += elapsed;
+  }
+#endif
+
+  tcb->budget_used += elapsed;
+
+  if (artxUNLIKELY(tcb->budget_used >= tcb->budget))
+  {
+    tcb->overruns++;
+
+#if ARTX_ENABLE_SPORADIC
+    if (tcb->sporadic)
+    {
+      artx_sporadic_defer(tcb);
+#if !ARTX_USE_ABS_RELEASE
+      /* the schedule is decremented below */
+      tcb->schedule++;
+#endif
+    }
+    else
+#endif
+    {
+      tcb->budget_used = 0;
+      tcb->schedule += artx_TCB_INTERVAL(tcb);
+    }
+
+#if ARTX_SCHED_EDF
+    artx_edf_remove(tcb);
+
+#if ARTX_USE_ABS_RELEASE
+    /* a task released on this very tick is inserted by the tick */
+    if (artx_SCHED_DIFF(artx_tick_count, tcb->schedule) > 0)
+#else
+    if (artx_IS_RELEASED(tcb))
+#endif
+    {
+      artx_edf_insert(tcb);
+    }
+#endif
+  }
+}
+
+#endif // ARTX_ENABLE_BUDGET
+
+#if ARTX_ENABLE_SPORADIC
+
+/**
+ *  Replenish sporadic server
+ *
+ *  \internal
+ *
+ *  This routine gives back all chunks of used capacity to a sporadic
+ *  server whose replenishment time has been reached.
+ *
+ *  Calls to this routine must be locked.
+ *
+ *  \param tcb                   Pointer to the task control block.
+ */
+
+static void artx_sporadic_replenish(struct artx_tcb *tcb)
+{
+  while (tcb->repl_count > 0)
+  {
+    struct artx_replenishment *r = &tcb->repl[tcb->repl_head];
+
+    if ((int32_t) (artx_tick_count - r->at) < 0)
+    {
+      break;
+    }
+
+    tcb->budget_used -= r->amount;
+
+    if (++tcb->repl_head == ARTX_SPORADIC_REPLENISHMENTS)
+    {
+      tcb->repl_head = 0;
+    }
+
+    tcb->repl_count--;
+  }
+}
+
+/**
+ *  Schedule replenishment for sporadic server
+ *
+ *  \internal
+ *
+ *  This routine ends the current activation of a sporadic server.
+ *  The capacity used since the server has been activated will be
+ *  replenished one interval after the activation. If there already
+ *  are #ARTX_SPORADIC_REPLENISHMENTS pending replenishments, the
+ *  capacity is added to the latest one, which is postponed. This
+ *  never gives back capacity too early.
+ *
+ *  Calls to this routine must be locked.
+ *
+ *  \param tcb                   Pointer to the task control block.
+ */
+
+static void artx_sporadic_post(struct artx_tcb *tcb)
+{
+  if (tcb->consumed == 0)
+  {
+    return;
+  }
+
+  uint8_t full = tcb->repl_count == ARTX_SPORADIC_REPLENISHMENTS;
+  uint8_t i = tcb->repl_head + tcb->repl_count - full;
+
+  if (i >= ARTX_SPORADIC_REPLENISHMENTS)
+  {
+    i -= ARTX_SPORADIC_REPLENISHMENTS;
+  }
+
+  struct artx_replenishment *r = &tcb->repl[i];
+
+  if (artxUNLIKELY(full))
+  {
+    r->amount += tcb->consumed;
+  }
+  else
+  {
+    r->amount = tcb->consumed;
+    tcb->repl_count++;
+  }
+
+  r->at = tcb->activated_at + tcb->interval;
+  tcb->consumed = 0;
+}
+
+/**
+ *  Defer sporadic server
+ *
+ *  \internal
+ *
+ *  This routine is called when a sporadic server has used up its
+ *  capacity. The server is deferred until the next replenishment,
+ *  which is also when its next activation starts.
+ *
+ *  Calls to this routine must be locked.
+ *
+ *  \param tcb                   Pointer to the task control block.
+ */
+
+static void artx_sporadic_defer(struct artx_tcb *tcb)
+{
+  artx_sporadic_post(tcb);
+
+  tcb->activated_at = tcb->repl[tcb->repl_head].at;
+  tcb->schedule = artx_RELEASE_IN(tcb->activated_at - artx_tick_count);
+}
+
+/**
+ *  Arm sporadic server
+ *
+ *  \internal
+ *
+ *  This routine prepares a sporadic server with pending requests
+ *  for being scheduled. If there's capacity left, the server will
+ *  be released immediately, otherwise at its next replenishment.
+ *
+ *  Calls to this routine must be locked.
+ *
+ *  \param tcb                   Pointer to the task control block.
+ */
+
+static void artx_sporadic_arm(struct artx_tcb *tcb)
+{
+  artx_sporadic_replenish(tcb);
+
+  if (tcb->budget == 0 || tcb->budget_used < tcb->budget)
+  {
+    tcb->schedule = artx_RELEASE_IN(0);
+  }
+  else
+  {
+    artx_sporadic_defer(tcb);
+  }
+}
+
+/**
+ *  Complete sporadic server request
+ *
+ *  \internal
+ *
+ *  This routine is called when a sporadic server has run all its
+ *  routines. If there are no more pending requests, the server is
+ *  removed from the task list.
+ *
+ *  Calls to this routine must be locked.
+ *
+ *  \param tcb                   Pointer to the task control block.
+ */
+
+static void artx_sporadic_complete(struct artx_tcb *tcb)
+{
+  if (--tcb->pending == 0)
+  {
+    artx_sporadic_post(tcb);
+    tcb->schedule = artx_RELEASE_IN(tcb->interval);
+    artx_task_unlink(tcb);
+  }
+  else
+  {
+    artx_sporadic_arm(tcb);
+  }
+}
+
+#endif // ARTX_ENABLE_SPORADIC
+
+/**
+ *  Save a task's context
+ *
+ *  \internal
+ *
+ *  This routine fully saves a task's context to its stack and
+ *  control block.
+ */
+
+static inline void artx_push_context(void)
+{
+  asm volatile (
+
+    "in    r31, __SREG__             \n\t" /* get SREG               */
+
+#if ARTX_ENABLE_MONITOR
+#if ARTX_USE_GPIOR
+    "out   %[gpior2], r31            \n\t" /* save SREG              */
+#else
+    "sts   artx_SREG, r31            \n\t" /* save SREG              */
+#endif
+
+    "sts   artx_R30, r30             \n\t" /* save R30               */
+    "sts   artx_R29, r29             \n\t" /* save R29               */
+
+    "lds   r30, artx_current_tcb     \n\t" /* load pointer to SP     */
+    "lds   r31, artx_current_tcb + 1 \n\t" /*   buffer into Z reg    */
 
     "in    r29, __SP_L__             \n\t" /* save low byte of SP    */
     "st    z+, r29                   \n\t"
@@ -428,11 +1723,19 @@ static inline void artx_push_context(void)
     "ld    r29, z+                   \n\t"
     "out   __SP_H__, r29             \n\t"
 
+#if ARTX_USE_GPIOR
+    "in    r31, %[gpior1]            \n\t" /* load R31               */
+    "push  r31                       \n\t" /* save R31               */
+
+    "in    r31, %[gpior2]            \n\t" /* load SREG              */
+    "push  r31                       \n\t" /* save SREG              */
+#else
     "lds   r31, artx_R31             \n\t" /* load R31               */
     "push  r31                       \n\t" /* save R31               */
 
     "lds   r31, artx_SREG            \n\t" /* load SREG              */
     "push  r31                       \n\t" /* save SREG              */
+#endif
 
     "lds   r30, artx_R30             \n\t" /* load R30               */
     "push  r30                       \n\t" /* save R30               */
@@ -462,6 +1765,7 @@ static inline void artx_push_context(void)
     "out   __SP_L__, r28             \n\t"
     "out   __SP_H__, r29             \n\t"
 
+    artx_GPIOR_OPERANDS
   );
 }
 
@@ -499,11 +1803,19 @@ static inline void artx_pop_context(void)
     "pop r30                         \n\t"
     "sts artx_R30, r30               \n\t"
 
+#if ARTX_USE_GPIOR
+    "pop r31                         \n\t"
+    "out %[gpior2], r31              \n\t"
+
+    "pop r31                         \n\t"
+    "out %[gpior1], r31              \n\t"
+#else
     "pop r31                         \n\t"
     "sts artx_SREG, r31              \n\t"
 
     "pop r31                         \n\t"
     "sts artx_R31, r31               \n\t"
+#endif
 
     "lds  r30, artx_current_tcb      \n\t" /* load pointer to CXT-SP */
     "lds  r31, artx_current_tcb + 1  \n\t" /*   buffer into Z reg    */
@@ -522,10 +1834,17 @@ static inline void artx_pop_context(void)
     "lds r29, artx_R29               \n\t"
     "lds r30, artx_R30               \n\t"
 
+#if ARTX_USE_GPIOR
+    "in  r31, %[gpior2]              \n\t" /* load original SREG     */
+    "out __SREG__, r31               \n\t" /* restore SREG           */
+
+    "in  r31, %[gpior1]              \n\t" /* restore R31            */
+#else
     "lds r31, artx_SREG              \n\t" /* load original SREG     */
     "out __SREG__, r31               \n\t" /* restore SREG           */
 
     "lds r31, artx_R31               \n\t" /* restore R31            */
+#endif
 #else
     "pop r30                         \n\t"
 
@@ -537,6 +1856,7 @@ static inline void artx_pop_context(void)
 
     "reti                            \n\t" /* return and enable intr */
 
+    artx_GPIOR_OPERANDS
   );
 }
 
@@ -562,17 +1882,24 @@ static void artx_yield(void)
 {
   asm volatile (
 
-#if ARTX_ENABLE_MONITOR
+#if ARTX_ENABLE_MONITOR && ARTX_USE_GPIOR
+    "out   %[gpior1], r31            \n\t" /* save R31               */
+#elif ARTX_ENABLE_MONITOR
     "sts   artx_R31, r31             \n\t" /* save R31               */
 #else
     "push  r31                       \n\t" /* save R31               */
 #endif
 
+#if ARTX_USE_GPIOR
+    "cbi   %[gpior0], 0              \n\t" /* clear tick indicator   */
+#else
     "ldi   r31, 0                    \n\t"
     "sts   artx_is_tick, r31         \n\t"
+#endif
 
     "artx_do_yield:                  \n\t"
 
+    artx_GPIOR_OPERANDS
   );
 
   artx_push_context();
@@ -586,8 +1913,30 @@ static void artx_yield(void)
    */
   asm volatile ("clr __zero_reg__");
 
-  if (artx_is_tick)
+  if (artx_IS_TICK())
   {
+    artx_TRACE_TICK();
+
+#if ARTX_ENABLE_PROFILE
+    artx_profile_sample();
+#endif
+
+#if ARTX_ENABLE_SAMPLING
+    artx_sampling_next();
+#endif
+
+#if ARTX_ENABLE_CLI_PROFILE
+    /* the tick disabled interrupts, the window ends in ARTX_schedule() */
+    artx_CLI_ENTER(_BV(SREG_I));
+#endif
+
+#if ARTX_ENABLE_MONITOR
+    /* the remaining tick processing is accounted to the kernel */
+    artx_timer_type elapsed = artx_elapsed_restart();
+#elif artx_USE_ELAPSED
+    artx_timer_type elapsed = artx_elapsed();
+#endif
+
 #if ARTX_ENABLE_TIME
     artx_us_tmp += artx_TICK_LENGTH_USEC;
     artx_us_time += artx_TICK_LENGTH_USEC;
@@ -599,24 +1948,70 @@ static void artx_yield(void)
     }
 #endif
 
+#if artx_USE_TICK_COUNT
+    artx_tick_count++;
+#endif
+
 #if ARTX_ENABLE_MONITOR
-    if (artx_current_tcb->mon.state == artx_MS_COLLECT)
+    artx_current_tcb->mon.current_cycles += elapsed;
+#endif
+
+#if ARTX_ENABLE_BUDGET
+    artx_budget_charge(artx_current_tcb, elapsed);
+#endif
+
+#if ARTX_ENABLE_MODES
+    if (artxUNLIKELY(artx_mode_request != 0))
     {
-      artx_current_tcb->mon.current_cycles += artx_elapsed();
+      artx_mode_apply();
     }
 #endif
 
+#if ARTX_SCHED_TABLE
+    if (--artx_tt_delay == 0)
+    {
+      artx_tt_release();
+    }
+#elif ARTX_USE_ABS_RELEASE
+# if ARTX_SCHED_EDF || ARTX_ENABLE_TRACE
+    /* the idle task is always last and is never released */
+    for (register struct artx_tcb *tcb = artx_task_list; tcb->next; tcb = tcb->next)
+    {
+      if (artx_SCHED_DIFF(tcb->schedule, artx_tick_count) == 0)
+      {
+        artx_TRACE(artx_TE_RELEASE, tcb);
+#  if ARTX_SCHED_EDF
+        artx_edf_insert(tcb);
+#  endif
+      }
+    }
+# endif
+#else
     for (register struct artx_tcb *tcb = artx_task_list; tcb; tcb = tcb->next)
     {
-      if (artxLIKELY(tcb->schedule > -32768))
+      if (artxLIKELY(tcb->schedule > artx_SCHED_MIN))
       {
+#if ARTX_SCHED_EDF
+        if (--tcb->schedule == 0)
+        {
+          artx_TRACE(artx_TE_RELEASE, tcb);
+          artx_edf_insert(tcb);
+        }
+#elif ARTX_ENABLE_TRACE
+        if (--tcb->schedule == 0)
+        {
+          artx_TRACE(artx_TE_RELEASE, tcb);
+        }
+#else
         tcb->schedule--;
+#endif
       }
     }
+#endif // ARTX_SCHED_TABLE
 
 #if ARTX_ENABLE_TICK_SYNC
 
-#if ARTX_ENABLE_MONITOR
+#if artx_USE_ELAPSED
     artx_last_timer_top = artx_CUR_TIMER_TOP;
 #endif
 
@@ -633,65 +2028,24 @@ static void artx_yield(void)
     {
       if (artxUNLIKELY(--artx_monitor_ctl.schedule == 0))
       {
-        for (register struct artx_tcb *tcb = artx_task_list; tcb; tcb = tcb->next)
-        {
-          switch (tcb->mon.state)
-          {
-            case artx_MS_COLLECT:
-              if (artxLIKELY(tcb->mon.run_counter > 0))
-              {
-                tcb->mon.state = artx_MS_READY;
-              }
-              else
-              {
-                tcb->mon.intervals++;
-              }
-              break;
-
-            case artx_MS_SENT:
-              tcb->mon.current_cycles = 0;
-              tcb->mon.state = artx_MS_COLLECT;
-              break;
-
-            default:
-              break;
-          }
+        artx_monitor_ctl.schedule = artx_monitor_ctl.interval;
 
-#if ARTX_USE_MULTI_ROUT
-          for (register struct artx_rcb *rcb = tcb->rout; rcb; rcb = rcb->next)
-          {
-            switch (rcb->mon.state)
-            {
-              case artx_MS_COLLECT:
-                if (artxLIKELY(rcb->mon.run_counter > 0))
-                {
-                  if (artxUNLIKELY(rcb->mon.running))
-                  {
-                    rcb->mon.current_cycles += tcb->mon.current_cycles;
-                  }
-
-                  rcb->mon.state = artx_MS_READY;
-                }
-                else
-                {
-                  rcb->mon.intervals++;
-                }
-                break;
-
-              case artx_MS_SENT:
-                rcb->mon.current_cycles = 0;
-                rcb->mon.state = artx_MS_COLLECT;
-                break;
-
-              default:
-                break;
-            }
-          }
-#endif
+        /* a bank may collect for a long time if the idle task starves */
+        if (artxLIKELY(artx_monitor_ctl.intervals[artx_monitor_ctl.bank] < UINT8_MAX))
+        {
+          artx_monitor_ctl.intervals[artx_monitor_ctl.bank]++;
         }
 
-        artx_monitor_ctl.schedule = artx_monitor_ctl.interval;
-        artx_monitor_ctl.transmit_request = 1;
+        /*
+         *  Only switch banks if the last one has been transmitted,
+         *  otherwise keep collecting into the current bank. All
+         *  per-task work is done by artx_monitor_transmit().
+         */
+        if (artxLIKELY(!artx_monitor_ctl.transmit_request))
+        {
+          artx_monitor_ctl.bank ^= 1;
+          artx_monitor_ctl.transmit_request = 1;
+        }
       }
     }
 #endif
@@ -732,183 +2086,684 @@ static void artx_run_task(void)
 
   for (;;)
   {
+#if ARTX_ENABLE_LATENCY
+    /* the task has just been dispatched after its release */
+    ARTX_disable_int();
+    tcb->mon.start_latency = artx_release_latency(tcb);
+    ARTX_enable_int();
+#endif
+
 #if ARTX_USE_MULTI_ROUT
 
+#if ARTX_ENABLE_SAMPLING
+    uint8_t index = 0;
+#endif
+
     for (register struct artx_rcb *p = tcb->rout; p; p = p->next)
     {
+#if ARTX_ENABLE_SAMPLING
+      index++;
+#endif
+
       if (artxLIKELY(artx_ROUT_IS_ENABLED(p)))
       {
 #if ARTX_ENABLE_MONITOR
         ARTX_disable_int();
+        p->mon.current_cycles = -(tcb->mon.current_cycles + artx_elapsed());
+        ARTX_enable_int();
+#endif
 
-        if (p->mon.state == artx_MS_COLLECT)
-        {
-          p->mon.current_cycles = -(tcb->mon.current_cycles + artx_elapsed());
-          p->mon.running = 1;
-        }
+#if ARTX_ENABLE_TRACE
+        ARTX_disable_int();
+        artx_TRACE(artx_TE_ROUT_START, p->rout);
+        ARTX_enable_int();
+#endif
+
+#if ARTX_ENABLE_SAMPLING
+        /* a single byte, so the sampling interrupt always sees a valid index */
+        tcb->mon.running = index;
+#endif
+
+        p->rout();
+
+#if ARTX_ENABLE_SAMPLING
+        tcb->mon.running = 0;
+#endif
+
+#if ARTX_ENABLE_TRACE
+        ARTX_disable_int();
+        artx_TRACE(artx_TE_ROUT_END, p->rout);
+        ARTX_enable_int();
+#endif
+
+#if ARTX_ENABLE_MONITOR
+        ARTX_disable_int();
+
+        p->mon.current_cycles += tcb->mon.current_cycles;
+        p->mon.current_cycles += artx_elapsed();
+
+        artx_monitor_charge(&p->mon.bank[artx_monitor_ctl.bank], p->mon.current_cycles);
+
+#if ARTX_ENABLE_HISTOGRAM
+        artx_monitor_histogram(p->mon.hist[artx_monitor_ctl.bank], p->mon.current_cycles);
+#endif
 
         ARTX_enable_int();
 #endif
+      }
+    }
+
+#else /* !ARTX_USE_MULTI_ROUT */
+
+#if ARTX_ENABLE_TRACE
+    ARTX_disable_int();
+    artx_TRACE(artx_TE_ROUT_START, artx_TCB_ROUT(tcb));
+    ARTX_enable_int();
+#endif
+
+    artx_TCB_ROUT(tcb)();
+
+#if ARTX_ENABLE_TRACE
+    ARTX_disable_int();
+    artx_TRACE(artx_TE_ROUT_END, artx_TCB_ROUT(tcb));
+    ARTX_enable_int();
+#endif
+
+#endif /* !ARTX_USE_MULTI_ROUT */
+
+#if ARTX_ENABLE_TRACE || ARTX_ENABLE_LOG
+    /* the idle task drains the trace and log buffers with interrupts enabled */
+    if (artxUNLIKELY(artx_TCB_PRIORITY(tcb) == artx_PRIO_IDLE))
+    {
+# if ARTX_ENABLE_TRACE
+      artx_trace_transmit();
+# endif
+# if ARTX_ENABLE_LOG
+      artx_log_transmit();
+# endif
+    }
+#endif
+
+#if ARTX_ENABLE_SAMPLING
+    if (artxUNLIKELY(artx_TCB_PRIORITY(tcb) == artx_PRIO_IDLE) &&
+        artxUNLIKELY(artx_sampling_ctl.transmit_request))
+    {
+      artx_sampling_ctl.transmit_request = 0;
+      artx_sampling_transmit();
+    }
+#endif
+
+#if ARTX_ENABLE_MONITOR
+    /* the request is only cleared once the last bank has been transmitted */
+    if (artxUNLIKELY(artx_TCB_PRIORITY(tcb) == artx_PRIO_IDLE) &&
+        artxUNLIKELY(artx_monitor_ctl.transmit_request))
+    {
+      artx_monitor_transmit();
+    }
+#endif
+
+    /* artx_yield() requires us to disable interrupts */
+    ARTX_disable_int();
+
+#if ARTX_ENABLE_LATENCY
+    /* the schedule still refers to the release this run belongs to */
+    artx_monitor_latency(&tcb->mon, artx_release_latency(tcb));
+#endif
+
+#if ARTX_ENABLE_SPORADIC
+    if (artxUNLIKELY(tcb->sporadic))
+    {
+      artx_sporadic_complete(tcb);
+    }
+    else
+#endif
+    {
+      tcb->schedule += artx_TCB_INTERVAL(tcb);
+
+#if ARTX_ENABLE_BUDGET
+      tcb->budget_used = 0;
+#endif
+    }
+
+#if ARTX_SCHED_EDF
+    if (artxLIKELY(tcb != artx_idle_tcb))
+    {
+      /* reinsert with new deadline if the task is already late */
+      artx_edf_remove(tcb);
+
+      if (artxUNLIKELY(artx_IS_RELEASED(tcb)))
+      {
+        artx_edf_insert(tcb);
+      }
+    }
+#endif
+
+#if ARTX_ENABLE_MONITOR
+
+    /* from here on, cycles are accounted to the kernel */
+    artx_timer_type elapsed = artx_elapsed_restart();
+
+    tcb->mon.current_cycles += elapsed;
+
+    artx_monitor_charge(&tcb->mon.bank[artx_monitor_ctl.bank], tcb->mon.current_cycles);
+
+#if ARTX_ENABLE_HISTOGRAM
+    artx_monitor_histogram(tcb->mon.hist[artx_monitor_ctl.bank], tcb->mon.current_cycles);
+#endif
+
+    tcb->mon.current_cycles = 0;
+
+#endif
+
+    /* interrupts have already been disabled above */
+    artx_yield();
+  }
+}
+
+
+/*===== FUNCTIONS ============================================================*/
+
+/**
+ *  Initialize Task
+ *
+ *  This routine initializes both the task control block as well as
+ *  the tasks stack. It also adds the task to the kernel's task list
+ *  so it will be scheduled when the kernel is running.
+ *
+ *  With #ARTX_USE_AUTO_INIT, this routine is called for all tasks
+ *  by the startup code and must not be called again.
+ *
+ *  \param tcb                   Pointer to the task control block.
+ */
+
+void ARTX_task_init(struct artx_tcb *tcb)
+{
+  artx_task_setup(tcb);
+  artx_task_link(tcb);
+
+#if ARTX_USE_ABS_RELEASE
+  /* the declared offset is relative to the time of initialization */
+  tcb->schedule += artx_tick_count;
+#endif
+
+#if ARTX_SCHED_TABLE
+  /* all releases are driven by the schedule table */
+  tcb->schedule = artx_TCB_INTERVAL(tcb);
+#endif
+
+#if ARTX_SCHED_EDF || ARTX_ENABLE_MODES
+  if (artx_TCB_PRIORITY(tcb) == artx_PRIO_IDLE)
+  {
+    artx_idle_tcb = tcb;
+  }
+#endif
+
+#if ARTX_SCHED_EDF
+  if (artx_TCB_PRIORITY(tcb) != artx_PRIO_IDLE && artx_IS_RELEASED(tcb))
+  {
+    artx_edf_insert(tcb);
+  }
+#endif
+}
+
+#if ARTX_USE_MULTI_ROUT
+
+/**
+ *  Push routine on a tasks run queue
+ *
+ *  Call this routine to push a routine allocated using #ARTX_ROUT on
+ *  the run queue of a task. The routine will be added to the end of
+ *  the run queue. Note that unless #ARTX_USE_MULTI_ROUT is defined to 1,
+ *  only one routine may be pushed and consecutive calls will silently
+ *  override the previous calls.
+ *
+ *  The same routine cannot be pushed pushed on the run queue of
+ *  different tasks.
+ *
+ *  \param tcb                   Pointer to the task control block.
+ *
+ *  \param rout                  Pointer to the routine control block.
+ */
+
+void ARTX_task_push_rout(struct artx_tcb *tcb, struct artx_rcb *rout)
+{
+  rout->next = 0;
+
+  struct artx_rcb **pp = &tcb->rout;
+
+  while (*pp)
+  {
+    pp = &(*pp)->next;
+  }
+
+  *pp = rout;
+}
+
+#endif
+
+#if ARTX_SCHED_EDF && !ARTX_SCHED_TABLE && !ARTX_USE_ROM_TCB
+
+/**
+ *  Set the interval of a task
+ *
+ *  Change the scheduling interval of a task. The new interval will
+ *  be used when the task is scheduled the next time. As the deadline
+ *  of a task is the end of its interval, the deadline of an already
+ *  released task is moved accordingly and the task is put back into
+ *  the EDF ready list at the right position.
+ *
+ *  Calls to this routine must be locked.
+ *
+ *  \param tcb                   Pointer to the task control block.
+ *
+ *  \param interval              The scheduling interval in multiples
+ *                               of the tick interval.
+ */
+
+void ARTX_task_set_interval(struct artx_tcb *tcb, ARTX_interval_type interval)
+{
+  uint8_t released = artx_edf_remove(tcb);
+
+  tcb->interval = interval;
+
+  if (released)
+  {
+    artx_edf_insert(tcb);
+  }
+}
+
+#endif
+
+#if ARTX_TASK_POOL_SIZE
+
+/**
+ *  Create a task
+ *
+ *  Allocate a task from the task pool and add it to the kernel's
+ *  task list. The task will use a user stack of #ARTX_TASK_POOL_STACK_SIZE
+ *  bytes. It will be released for the first time \e offset ticks after
+ *  the next tick. This routine can be called before the scheduler has
+ *  been started as well as while it is running.
+ *
+ *  As tasks created from the pool cannot be part of an operating
+ *  mode, they are removed from the task list by the next mode switch
+ *  and their control block and stack are returned to the pool.
+ *
+ *  Calls to this routine must be locked.
+ *
+ *  \param prio                  The unique user priority of the task.
+ *
+ *  \param interval              The scheduling interval in multiples
+ *                               of the tick interval.
+ *
+ *  \param offset                The scheduling offset in multiples
+ *                               of the tick interval.
+ *
+ *  \param rout                  The routine to run in the task.
+ *
+ *  \returns Pointer to the task control block, or null if the
+ *           pool is exhausted.
+ */
+
+#if ARTX_USE_MULTI_ROUT
+struct artx_tcb *ARTX_task_create(uint8_t prio, ARTX_interval_type interval,
+                                  ARTX_interval_type offset, struct artx_rcb *rout)
+#else
+struct artx_tcb *ARTX_task_create(uint8_t prio, ARTX_interval_type interval,
+                                  ARTX_interval_type offset, void (*rout)(void))
+#endif
+{
+  uint8_t i = 0;
+
+  while (artx_pool_tcb[i].priority != 0)
+  {
+    if (++i == ARTX_TASK_POOL_SIZE)
+    {
+      return 0;
+    }
+  }
+
+  register struct artx_tcb *tcb = &artx_pool_tcb[i];
+  uint8_t *stack = artx_pool_stack[i];
+
+  tcb->sp = (uint16_t) &stack[sizeof(artx_pool_stack[0]) - 1];
+#if ARTX_ENABLE_MONITOR
+  tcb->sp_cxt = (uint16_t) &stack[artx_CONTEXT_SIZE - 1];
+
+  struct artx_monitor_task mon = {
+    .stack_size = ARTX_TASK_POOL_STACK_SIZE,
+    .stack = { .base = &stack[artx_CONTEXT_SIZE] },
+    .name = artx_pool_name
+  };
+
+  tcb->mon = mon;
+#elif ARTX_ENABLE_SAMPLING
+  struct artx_sampling_task mon = {
+    .name = artx_pool_name
+  };
+
+  tcb->mon = mon;
+#endif
+#if ARTX_ENABLE_STACK_CHECK && !ARTX_ENABLE_MONITOR
+  tcb->stack.base = stack;
+#endif
+#if ARTX_USE_MULTI_ROUT
+  tcb->rout = 0;
+  ARTX_task_push_rout(tcb, rout);
+#else
+  tcb->rout = rout;
+#endif
+  tcb->interval = interval;
+  tcb->schedule = artx_RELEASE_IN(offset + 1);
+#if ARTX_USE_TASK_SUSPEND
+  tcb->state = ARTX_TS_ACTIVE;
+#endif
+#if ARTX_ENABLE_BUDGET
+  tcb->budget = 0;
+  tcb->budget_used = 0;
+  tcb->overruns = 0;
+#endif
+  tcb->priority = prio + artx_PRIO_USER_OFFSET;
 
-        p->rout();
+  artx_task_setup(tcb);
+  artx_task_link(tcb);
 
-#if ARTX_ENABLE_MONITOR
-        ARTX_disable_int();
+  return tcb;
+}
 
-        if (p->mon.state == artx_MS_COLLECT)
-        {
-          p->mon.running = 0;
-          p->mon.run_counter++;
-          p->mon.current_cycles += tcb->mon.current_cycles;
-          p->mon.current_cycles += artx_elapsed();
-
-          if (p->mon.current_cycles > p->mon.peak_cycles)
-          {
-            p->mon.peak_cycles = p->mon.current_cycles;
-          }
-
-          p->mon.total_cycles += p->mon.current_cycles;
-          p->mon.current_cycles = 0;
-        }
+/**
+ *  Terminate the current task
+ *
+ *  Remove the calling task from the kernel's task list and yield to
+ *  the scheduler. If the task has been created using ARTX_task_create(),
+ *  its control block and stack are returned to the task pool. Tasks
+ *  declared using #ARTX_TASK can exit as well, but their resources
+ *  obviously cannot be reused. The idle task must never exit.
+ *
+ *  This routine never returns.
+ */
 
-        ARTX_enable_int();
+void ARTX_task_exit(void)
+{
+  /* artx_yield() requires us to disable interrupts */
+  ARTX_disable_int();
+
+  register struct artx_tcb *tcb = artx_current_tcb;
+
+  artx_task_unlink(tcb);
+
+#if ARTX_SCHED_EDF
+  artx_edf_remove(tcb);
 #endif
-      }
-    }
 
-#else /* !ARTX_USE_MULTI_ROUT */
+  /*
+   *  Once the priority is cleared, the pool entry may be reused.
+   *  This is safe, as interrupts remain disabled until we've left
+   *  the task's stack in artx_yield(), and the task will never be
+   *  resumed again.
+   */
+  tcb->priority = 0;
 
-    tcb->rout();
+  artx_yield();
 
-#endif /* !ARTX_USE_MULTI_ROUT */
+  for (;;)
+  { }
+}
 
-    /* artx_yield() requires us to disable interrupts */
-    asm volatile ("cli");
+#endif // ARTX_TASK_POOL_SIZE
 
-    tcb->schedule += tcb->interval;
+#if ARTX_ENABLE_SPORADIC
 
-#if ARTX_ENABLE_MONITOR
+/**
+ *  Initialize Sporadic Server
+ *
+ *  Use this routine instead of ARTX_task_init() to initialize a
+ *  task declared using #ARTX_TASK as a sporadic server. The interval
+ *  of the task is used as the replenishment period. The server will
+ *  not be part of the kernel's task list until a request is posted
+ *  using ARTX_sporadic_request().
+ *
+ *  With #ARTX_USE_AUTO_INIT, this routine removes the task from the
+ *  task list it has been added to by the startup code.
+ *
+ *  \param tcb                   Pointer to the task control block.
+ *
+ *  \param capacity              The execution time available to the
+ *                               server per interval, in units of the
+ *                               timer used as the tick source. A
+ *                               capacity of zero means unlimited.
+ */
 
-    if (tcb->mon.state == artx_MS_COLLECT)
-    {
-      tcb->mon.run_counter++;
-      tcb->mon.current_cycles += artx_elapsed();
+void ARTX_sporadic_init(struct artx_tcb *tcb, uint32_t capacity)
+{
+#if ARTX_USE_AUTO_INIT
+  /* the task has already been set up and linked at startup */
+  artx_task_unlink(tcb);
+#else
+  artx_task_setup(tcb);
+#endif
 
-      if (tcb->mon.current_cycles > tcb->mon.peak_cycles)
-      {
-        tcb->mon.peak_cycles = tcb->mon.current_cycles;
-      }
+  tcb->sporadic = 1;
+  tcb->pending = 0;
+  tcb->budget = capacity;
+  tcb->budget_used = 0;
+  tcb->repl_head = 0;
+  tcb->repl_count = 0;
+  tcb->consumed = 0;
+  tcb->schedule = artx_RELEASE_IN(tcb->interval);
+}
 
-      tcb->mon.total_cycles += tcb->mon.current_cycles;
-      tcb->mon.current_cycles = 0;
-    }
+/**
+ *  Post Request to Sporadic Server
+ *
+ *  Post a request to a sporadic server. The server will run all its
+ *  routines once for each request. If the server still has capacity
+ *  left, it will be released immediately and run as soon as the
+ *  scheduler is invoked the next time, i.e. at the next tick or when
+ *  the current task yields. Otherwise, it will be released when its
+ *  capacity is replenished.
+ *
+ *  This routine can be called from interrupt handlers. Up to 255
+ *  requests can be pending, further requests will be dropped.
+ *
+ *  Calls to this routine must be locked.
+ *
+ *  \param tcb                   Pointer to the task control block.
+ */
 
-    if (artxUNLIKELY(tcb->priority == artx_PRIO_IDLE) &&
-        artxUNLIKELY(artx_monitor_ctl.transmit_request))
+void ARTX_sporadic_request(struct artx_tcb *tcb)
+{
+  if (artxUNLIKELY(tcb->pending == 0xFF))
+  {
+    return;
+  }
+
+  if (tcb->pending++ == 0)
+  {
+    /* a new activation starts unless the server is out of capacity */
+    tcb->activated_at = artx_tick_count;
+    artx_sporadic_arm(tcb);
+    artx_task_link(tcb);
+
+#if ARTX_SCHED_EDF
+    if (artx_IS_RELEASED(tcb))
     {
-      artx_monitor_ctl.transmit_request = 0;
-      artx_monitor_transmit();
+      artx_edf_insert(tcb);
     }
-
 #endif
-
-    /* interrupts have already been disabled above */
-    artx_yield();
   }
 }
 
+#endif // ARTX_ENABLE_SPORADIC
 
-/*===== FUNCTIONS ============================================================*/
+#if ARTX_USE_TASK_SUSPEND
 
 /**
- *  Initialize Task
+ *  Suspend a task
  *
- *  This routine initializes both the task control block as well as
- *  the tasks stack. It also adds the task to the kernel's task list
- *  so it will be scheduled when the kernel is running.
+ *  Remove a task from the kernel's task list. A suspended task will
+ *  not be released, scheduled or updated by the tick until it is
+ *  resumed using ARTX_task_resume(). If a task suspends itself, it
+ *  immediately yields to the scheduler and the call returns only
+ *  after the task has been resumed. In that case, interrupts will
+ *  be enabled upon return. The idle task cannot be suspended, and
+ *  calls for tasks that are not active are ignored.
+ *
+ *  A task that is suspended while it has a pending release will
+ *  keep at most one pending release.
+ *
+ *  Calls to this routine must be locked.
  *
  *  \param tcb                   Pointer to the task control block.
  */
 
-void ARTX_task_init(struct artx_tcb *tcb)
+void ARTX_task_suspend(struct artx_tcb *tcb)
 {
-#if ARTX_ENABLE_MONITOR
-  artx_monitor_task_init(&tcb->mon);
+  if (artx_TCB_PRIORITY(tcb) == artx_PRIO_IDLE || tcb->state != ARTX_TS_ACTIVE)
+  {
+    return;
+  }
+
+  artx_task_unlink(tcb);
+
+#if ARTX_SCHED_EDF
+  artx_edf_remove(tcb);
 #endif
 
-  uint8_t *sp = (uint8_t *) tcb->sp;
-  uint16_t raddr = (uint16_t) &artx_run_task;
+  /* keep the schedule relative to the tick while suspended */
+#if ARTX_USE_ABS_RELEASE
+  artx_sched_diff_type schedule = artx_SCHED_DIFF(tcb->schedule, artx_tick_count);
+#else
+  artx_sched_diff_type schedule = tcb->schedule;
+#endif
 
-  /* initialize stack by simulating a context push */
+  if (schedule <= 0)
+  {
+    schedule = -(artx_sched_diff_type) ((ARTX_interval_type) -schedule %
+                                        (ARTX_interval_type) tcb->interval);
+  }
 
-  *sp-- = raddr & 0xFF;    /* return address low byte   */
-  *sp-- = raddr >> 8;      /* return address high byte  */
+  tcb->schedule = schedule;
 
-#if ARTX_ENABLE_MONITOR
-  /* switch from user stack to context stack */
-  tcb->sp = (uint16_t) sp;
+  tcb->state = ARTX_TS_SUSPENDED;
+  tcb->suspended_at = artx_tick_count;
 
-  sp = (uint8_t *) tcb->sp_cxt;
-#endif
+  if (tcb == artx_current_tcb)
+  {
+    artx_yield();
+  }
+}
+
+/**
+ *  Resume a task
+ *
+ *  Put a task that has been suspended using ARTX_task_suspend()
+ *  back into the kernel's task list. The release phase of the task
+ *  is restored as if the task had never been suspended, but all
+ *  releases that would have happened while the task was suspended
+ *  are skipped. A release that was pending when the task was
+ *  suspended is kept.
+ *
+ *  With #ARTX_ENABLE_MODES, a task that is not part of the current
+ *  operating mode cannot be resumed. It becomes inactive instead and
+ *  will only be scheduled again once a mode it is part of has been
+ *  activated.
+ *
+ *  Calls to this routine must be locked.
+ *
+ *  \param tcb                   Pointer to the task control block.
+ */
 
-  for (uint8_t r = 33; r--; )
+void ARTX_task_resume(struct artx_tcb *tcb)
+{
+  if (tcb->state != ARTX_TS_SUSPENDED)
   {
-    *sp-- = 0;             /* R31, SREG, R30 .. R0      */
+    return;
   }
 
-#if ARTX_ENABLE_MONITOR
-  tcb->sp_cxt = (uint16_t) sp;
-#else
-  tcb->sp = (uint16_t) sp;
+#if ARTX_ENABLE_MODES
+  if (artx_current_mode && !artx_mode_has_task(artx_current_mode, tcb))
+  {
+    tcb->state = ARTX_TS_INACTIVE;
+    return;
+  }
 #endif
 
-  /* sort tasks by priority */
+  artx_sched_diff_type schedule = tcb->schedule;
+  ARTX_interval_type interval = tcb->interval;
+  ARTX_interval_type pending = schedule <= 0 ? interval : 0;
+  ARTX_interval_type next = schedule + pending;
+  uint32_t elapsed = artx_tick_count - tcb->suspended_at;
 
-  struct artx_tcb **pp = &artx_task_list;
-
-  while (*pp && tcb->priority >= (*pp)->priority)
+  if (elapsed < next)
   {
-    pp = &(*pp)->next;
+    next -= elapsed;
+  }
+  else
+  {
+    ARTX_interval_type phase = (elapsed - next) % interval;
+    next = phase ? interval - phase : 0;
   }
 
-  tcb->next = *pp;
-  *pp = tcb;
+  tcb->schedule = artx_RELEASE_IN(next - pending);
+  tcb->state = ARTX_TS_ACTIVE;
+
+  artx_task_link(tcb);
+
+#if ARTX_SCHED_EDF
+  if (artx_IS_RELEASED(tcb))
+  {
+    artx_edf_insert(tcb);
+  }
+#endif
 }
 
-#if ARTX_USE_MULTI_ROUT
+#endif // ARTX_USE_TASK_SUSPEND
+
+#if ARTX_ENABLE_MODES
 
 /**
- *  Push routine on a tasks run queue
+ *  Switch operating mode
  *
- *  Call this routine to push a routine allocated using #ARTX_ROUT on
- *  the run queue of a task. The routine will be added to the end of
- *  the run queue. Note that unless #ARTX_USE_MULTI_ROUT is defined to 1,
- *  only one routine may be pushed and consecutive calls will silently
- *  override the previous calls.
+ *  Request a switch to a different operating mode declared using
+ *  #ARTX_MODE. The switch is performed atomically at the next tick:
+ *  the kernel's task list is replaced by the tasks of the new mode
+ *  plus the idle task, and each task is released \e offset ticks
+ *  after that tick, using the interval given for the new mode.
  *
- *  The same routine cannot be pushed pushed on the run queue of
- *  different tasks.
+ *  Until the first mode switch, all tasks initialized using
+ *  ARTX_task_init() are active. If multiple switches are requested
+ *  within the same tick, only the last one takes effect.
+ *  Suspended tasks that are part of the new mode will become
+ *  active again.
  *
- *  \param tcb                   Pointer to the task control block.
+ *  Calls to this routine must be locked.
  *
- *  \param rout                  Pointer to the routine control block.
+ *  \param mode                  Pointer to the operating mode.
  */
 
-void ARTX_task_push_rout(struct artx_tcb *tcb, struct artx_rcb *rout)
+void ARTX_mode_switch(const struct artx_mode *mode)
 {
-  rout->next = 0;
-
-  struct artx_rcb **pp = &tcb->rout;
+  artx_mode_request = mode;
+}
 
-  while (*pp)
-  {
-    pp = &(*pp)->next;
-  }
+/**
+ *  Get current operating mode
+ *
+ *  This routine returns the currently active operating mode. A
+ *  mode switch that has been requested, but not yet performed is
+ *  not taken into account.
+ *
+ *  \returns Pointer to the current operating mode, or null if no
+ *           mode has been activated yet.
+ */
 
-  *pp = rout;
+const struct artx_mode *ARTX_mode_current(void)
+{
+  return artx_current_mode;
 }
 
-#endif
+#endif // ARTX_ENABLE_MODES
 
 /**
  *  Run the scheduler
@@ -927,6 +2782,23 @@ void ARTX_schedule(void)
 {
   asm volatile ("artx_task_switch:");
 
+#if ARTX_SCHED_EDF
+
+  /*
+   *  The EDF ready list is sorted by deadline, so we just need
+   *  to pick its first element. If no task has been released,
+   *  the idle task is run.
+   */
+
+  register struct artx_tcb *tcb = artx_edf_list;
+
+  if (tcb == 0)
+  {
+    tcb = artx_idle_tcb;
+  }
+
+#else
+
   register struct artx_tcb *tcb = artx_task_list;
 
   /*
@@ -958,7 +2830,12 @@ void ARTX_schedule(void)
    *  are scheduled in arbitrary order.
    */
 
+#if ARTX_USE_ABS_RELEASE
+  /* the idle task is always ready, no matter how long the uptime */
+  while (artx_TCB_PRIORITY(tcb) != artx_PRIO_IDLE && !artx_IS_RELEASED(tcb))
+#else
   while (tcb->schedule > 0)
+#endif
   {
     tcb = tcb->next;
   }
@@ -969,6 +2846,8 @@ void ARTX_schedule(void)
   //   /* only need to check this if tasks can be terminated? */
   // }
 
+#endif // ARTX_SCHED_EDF
+
   /*
    *  If the same task is about to be run again, there's no
    *  need to switch at all.
@@ -976,15 +2855,56 @@ void ARTX_schedule(void)
   if (tcb != artx_current_tcb)
   {
     artx_current_tcb = tcb;
+    artx_TRACE(artx_TE_SWITCH, tcb);
   }
 
 #if ARTX_ENABLE_MONITOR
+  artx_monitor_charge(&artx_monitor_kernel.bank[artx_monitor_ctl.bank], artx_elapsed_restart());
+#elif artx_USE_ELAPSED
   artx_last_timer = artx_TIMER_REG;
 #endif
 
+#if ARTX_ENABLE_CLI_PROFILE
+  artx_cli_end();
+#endif
+
   artx_pop_context();
 }
 
+#if ARTX_ENABLE_MONITOR
+
+/**
+ *  Run interrupt service routine with cycle accounting
+ *
+ *  \internal
+ *
+ *  This routine is used by interrupt service routines declared
+ *  using ARTX_ISR() to run the actual routine. The time spent is
+ *  accounted to the routine and skipped, so it won't be accounted
+ *  to the interrupted task as well.
+ *
+ *  Calls to this routine must be locked.
+ *
+ *  \param acc                   Pointer to cycle accounting of the
+ *                               interrupt service routine.
+ *
+ *  \param isr                   The actual interrupt service routine.
+ */
+
+void artx_monitor_run_isr(struct artx_monitor_account *acc, void (*isr)(void))
+{
+  artx_timer_type start = artx_elapsed();
+
+  isr();
+
+  artx_timer_type cycles = artx_elapsed() - start;
+
+  artx_elapsed_skip(cycles);
+  artx_monitor_charge(&acc->bank[artx_monitor_ctl.bank], cycles);
+}
+
+#endif
+
 #ifdef artx_TICK_VECTOR
 
 /**
@@ -999,16 +2919,24 @@ void ARTX_schedule(void)
 ISR(artx_TICK_VECTOR, ISR_NAKED)
 {
   asm volatile (
-#if ARTX_ENABLE_MONITOR
+#if ARTX_ENABLE_MONITOR && ARTX_USE_GPIOR
+    "out   %[gpior1], r31            \n\t" /* save R31               */
+#elif ARTX_ENABLE_MONITOR
     "sts   artx_R31, r31             \n\t" /* save R31               */
 #else
     "push  r31                       \n\t" /* save R31               */
 #endif
 
+#if ARTX_USE_GPIOR
+    "sbi   %[gpior0], 0              \n\t" /* set tick indicator     */
+#else
     "ldi   r31, 1                    \n\t"
     "sts   artx_is_tick, r31         \n\t"
+#endif
 
     "rjmp  artx_do_yield             \n\t"
+
+    artx_GPIOR_OPERANDS
   );
 }
 
@@ -1018,6 +2946,55 @@ ISR(artx_TICK_VECTOR, ISR_NAKED)
 
 #endif
 
+#if ARTX_ENABLE_SAMPLING
+
+/**
+ *  Sampling Interrupt
+ *
+ *  \internal
+ *
+ *  This routine is triggered once per tick at the point set by
+ *  artx_sampling_next() and counts a sample for the running task
+ *  and, with #ARTX_USE_MULTI_ROUT, for its running routine. The
+ *  kernel runs with interrupts disabled, so the running task is
+ *  always the current task.
+ */
+
+ARTX_ISR(artx_SAMPLE_VECTOR)
+{
+  register struct artx_tcb *tcb = artx_current_tcb;
+
+  tcb->mon.samples++;
+
+#if ARTX_USE_MULTI_ROUT
+  uint8_t index = tcb->mon.running;
+
+  if (index)
+  {
+    register struct artx_rcb *rcb = tcb->rout;
+
+    /* the list may have changed since the index was set */
+    while (rcb && --index)
+    {
+      rcb = rcb->next;
+    }
+
+    if (rcb)
+    {
+      rcb->mon.samples++;
+    }
+  }
+#endif
+
+  if (--artx_sampling_ctl.countdown == 0)
+  {
+    artx_sampling_ctl.countdown = ARTX_SAMPLING_INTERVAL;
+    artx_sampling_ctl.transmit_request = 1;
+  }
+}
+
+#endif
+
 #if ARTX_ENABLE_TICK_SYNC
 
 /**
@@ -1232,3 +3209,65 @@ uint32_t ARTX_us_time(void)
 
 #endif
 
+
+#if ARTX_ENABLE_MONITOR || ARTX_ENABLE_SAMPLING
+
+/**
+ *  Walk task list
+ *
+ *  \internal
+ *
+ *  This routine allows the monitor to visit all tasks in the task
+ *  list with interrupts enabled, while mode switches, the task pool,
+ *  sporadic servers or suspend/resume may change the list. Each call
+ *  returns the next task that hasn't been visited yet during the
+ *  current walk. If the list has changed since the last call, the
+ *  walk continues from the head of the list, skipping all tasks
+ *  already visited. So each task is visited at most once, and each
+ *  task that remains in the list is visited.
+ *
+ *  \param tcb                   Pointer to the task returned by the
+ *                               last call, or null to start a new walk.
+ *
+ *  \returns Pointer to the next task, or null if all tasks have been
+ *           visited.
+ */
+
+struct artx_tcb *artx_task_walk(struct artx_tcb *tcb)
+{
+  static uint8_t walk;
+  static uint8_t gen;
+
+  ARTX_lock();
+
+  if (tcb == 0 || gen != artx_task_list_gen)
+  {
+    if (tcb == 0)
+    {
+      walk++;
+    }
+
+    gen = artx_task_list_gen;
+    tcb = artx_task_list;
+  }
+  else
+  {
+    tcb = tcb->next;
+  }
+
+  while (tcb && tcb->mon.walk == walk)
+  {
+    tcb = tcb->next;
+  }
+
+  if (tcb)
+  {
+    tcb->mon.walk = walk;
+  }
+
+  ARTX_unlock();
+
+  return tcb;
+}
+
+#endif
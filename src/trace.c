@@ -0,0 +1,145 @@
+/*******************************************************************************
+*
+* ARTX event tracing
+*
+********************************************************************************
+*
+* ARTX - A realtime executive library for Atmel AVR microcontrollers
+*
+* Copyright (C) 2007-2015 Marcus Holland-Moritz.
+*
+* ARTX is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* ARTX is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with ARTX.  If not, see <http://www.gnu.org/licenses/>.
+*
+*******************************************************************************/
+
+/**
+ *  \file trace.c
+ *  \brief Event tracing
+ */
+
+
+/*===== GLOBAL INCLUDES ======================================================*/
+
+#include <avr/io.h>
+
+
+/*===== LOCAL INCLUDES =======================================================*/
+
+#include "artx/trace.h"
+#include "artx/serial.h"
+#include "artx/util.h"
+
+#if ARTX_ENABLE_TRACE
+
+
+/*===== DEFINES ==============================================================*/
+
+/*===== TYPEDEFS =============================================================*/
+
+/*===== STATIC FUNCTION PROTOTYPES ===========================================*/
+
+/*===== EXTERNAL VARIABLES ===================================================*/
+
+/*===== GLOBAL VARIABLES =====================================================*/
+
+/**
+ *  Trace buffer
+ *
+ *  \internal
+ *
+ *  Ring buffer holding the recorded events. Events are written at
+ *  #artx_trace_head by the kernel and read at #artx_trace_tail by
+ *  artx_trace_transmit(). Both indices are free-running.
+ */
+struct artx_trace_event artx_trace_buf[ARTX_TRACE_SIZE];
+
+volatile uint8_t artx_trace_head;  //!< Next event to write \internal
+volatile uint8_t artx_trace_tail;  //!< Next event to send \internal
+uint8_t artx_trace_lost;           //!< Events lost since last message \internal
+uint16_t artx_trace_ticks;         //!< Tick counter \internal
+
+
+/*===== STATIC VARIABLES =====================================================*/
+
+/**
+ *  ARTX trace frame marker
+ *
+ *  \internal
+ *
+ *  This marker is sent at the beginning of each trace message to
+ *  synchronize the serial stream.
+ */
+static const char artx_trace_marker[] PROGMEM = "ARTT";
+
+
+/*===== STATIC FUNCTIONS =====================================================*/
+
+/*===== FUNCTIONS ============================================================*/
+
+/**
+ *  Transmit trace events
+ *
+ *  \internal
+ *
+ *  This routine transmits all events that are currently in the
+ *  trace buffer. It is called from the idle task with interrupts
+ *  enabled. As the kernel never overwrites events that have not
+ *  been sent, the events are read without locking.
+ */
+
+void artx_trace_transmit(void)
+{
+  static struct artx_trace_header header;
+
+  uint8_t tail = artx_trace_tail;
+  uint8_t count = artx_trace_head - tail;
+
+  ARTX_disable_int();
+
+  uint8_t lost = artx_trace_lost;
+  artx_trace_lost = 0;
+
+  ARTX_enable_int();
+
+  if (count == 0 && lost == 0)
+  {
+    return;
+  }
+
+  header.version = artx_TRACE_VERSION;
+  header.hdr_size = sizeof(struct artx_trace_header);
+  header.event_size = sizeof(struct artx_trace_event);
+  header.count = count;
+  header.lost = lost;
+  header.tick_duration = artx_TIMER_TOP;
+  header.tick_prescaler = ARTX_TICK_PRESCALER;
+  header.clock_frequency = ARTX_CLOCK_FREQUENCY;
+
+#if ARTX_ENABLE_SERIAL
+  ARTX_serial_tx_string_pgm(artx_trace_marker);
+  ARTX_serial_tx_data(&header, sizeof(struct artx_trace_header));
+#endif
+
+  while (count--)
+  {
+#if ARTX_ENABLE_SERIAL
+    ARTX_serial_tx_data(&artx_trace_buf[tail & (ARTX_TRACE_SIZE - 1)],
+                        sizeof(struct artx_trace_event));
+#endif
+
+    artx_trace_tail = ++tail;
+  }
+}
+
+#endif
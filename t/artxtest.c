@@ -30,12 +30,56 @@
 #include "artx/serial.h"
 #include "artx/monitor.h"
 
+#ifndef TEST_OVERRUN
+# define TEST_OVERRUN 0
+#endif
+
+#if TEST_OVERRUN
+void overrun_init(void);
+#endif
+
+/*
+ *  The test variants built by test.py override some of the settings
+ *  in testconfig.h. All variants must produce the same schedule.
+ */
+
+#if ARTX_USE_ROM_TCB
+ARTX_ROM_TASK(intr,   0,   1, 12, run_intr); //  2 ms
+ARTX_ROM_TASK(ut0,    1,   4, 16, run_ut0);  //  8 ms
+ARTX_ROM_TASK(ut1,    2,  25, 16, run_ut1);  // 50 ms
+ARTX_ROM_TASK(ut2,    3,  16, 14, run_ut2);  // 32 ms
+ARTX_ROM_TASK(ut3,    4,  32, 14, run_ut3);  // 64 ms
+ARTX_ROM_IDLE_TASK(idle, 20, background);
+#else
 ARTX_TASK(intr,   0,   1, 12); //  2 ms
 ARTX_TASK(ut0,    1,   4, 16); //  8 ms
 ARTX_TASK(ut1,    2,  25, 16); // 50 ms
 ARTX_TASK(ut2,    3,  16, 14); // 32 ms
+# if !ARTX_TASK_POOL_SIZE
 ARTX_TASK(ut3,    4,  32, 14); // 64 ms
+# endif
 ARTX_IDLE_TASK(idle, 20);
+#endif
+
+#if ARTX_SCHED_TABLE
+# include "artxtest_ttable.h"
+#endif
+
+#if ARTX_ENABLE_MODES
+/* deliberately not in order of priority */
+ARTX_MODE(all_tasks,
+          ARTX_MODE_TASK(ut2,  16, 0),
+          ARTX_MODE_TASK(intr,  1, 0),
+          ARTX_MODE_TASK(ut0,   4, 0),
+          ARTX_MODE_TASK(ut3,  32, 0),
+          ARTX_MODE_TASK(ut1,  25, 0));
+#endif
+
+#if ARTX_USE_AUTO_INIT && !ARTX_USE_ROM_TCB
+# define TEST_ROUT(task, routine)  ARTX_TASK_ROUT(task, routine)
+#else
+# define TEST_ROUT(task, routine)  ARTX_ROUT(routine)
+#endif
 
 void eat_it(uint8_t task, uint16_t loop) __attribute__((noinline));
 
@@ -58,44 +102,48 @@ void eat_cycles(uint8_t task, uint16_t num)
   }
 }
 
-ARTX_ROUT(run_intr)
+TEST_ROUT(intr, run_intr)
 {
   eat_cycles(0, 4);
 }
 
-ARTX_ROUT(run_ut0)
+TEST_ROUT(ut0, run_ut0)
 {
   eat_cycles(1, 10);
 }
 
-ARTX_ROUT(run_ut1)
+TEST_ROUT(ut1, run_ut1)
 {
   eat_cycles(2, 20);
 }
 
 #if ARTX_USE_MULTI_ROUT
-ARTX_ROUT(more_complex)
+TEST_ROUT(ut1, more_complex)
 {
   eat_cycles(2, 30);
 }
 
-ARTX_ROUT(less_complex)
+TEST_ROUT(ut1, less_complex)
 {
   eat_cycles(2, 10);
 }
 #endif
 
-ARTX_ROUT(run_ut2)
+TEST_ROUT(ut2, run_ut2)
 {
   eat_cycles(3, 20);
 }
 
+#if ARTX_TASK_POOL_SIZE
 ARTX_ROUT(run_ut3)
+#else
+TEST_ROUT(ut3, run_ut3)
+#endif
 {
   eat_cycles(4, 20);
 }
 
-ARTX_ROUT(background)
+TEST_ROUT(idle, background)
 {
   eat_cycles(5, 20);
 }
@@ -110,23 +158,58 @@ int main(void)
   ARTX_monitor_set_interval(1024);  // every 2 seconds
 #endif
 
+#if !ARTX_USE_AUTO_INIT
   ARTX_task_init(&intr);
   ARTX_task_init(&ut0);
   ARTX_task_init(&ut1);
   ARTX_task_init(&ut2);
+# if !ARTX_TASK_POOL_SIZE
   ARTX_task_init(&ut3);
+# endif
   ARTX_task_init(&idle);
+#endif
 
+#if !ARTX_USE_AUTO_INIT && !ARTX_USE_ROM_TCB
   ARTX_task_push_rout(&intr, &run_intr);
   ARTX_task_push_rout(&ut0, &run_ut0);
   ARTX_task_push_rout(&ut1, &run_ut1);
-#if ARTX_USE_MULTI_ROUT
+# if ARTX_USE_MULTI_ROUT
   ARTX_task_push_rout(&ut1, &more_complex);
   ARTX_task_push_rout(&ut1, &less_complex);
-#endif
+# endif
   ARTX_task_push_rout(&ut2, &run_ut2);
+# if !ARTX_TASK_POOL_SIZE
   ARTX_task_push_rout(&ut3, &run_ut3);
+# endif
   ARTX_task_push_rout(&idle, &background);
+#endif
+
+#if ARTX_TASK_POOL_SIZE
+  ARTX_task_create(4, 32, 0, &run_ut3);
+#endif
+
+#if ARTX_ENABLE_BUDGET
+  // generous budgets that must never be exceeded
+  ARTX_task_set_budget(&intr, ARTX_TICK_DURATION);
+  ARTX_task_set_budget(&ut0, ARTX_TICK_DURATION);
+  ARTX_task_set_budget(&ut1, ARTX_TICK_DURATION);
+  ARTX_task_set_budget(&ut2, ARTX_TICK_DURATION);
+#endif
+
+#if ARTX_USE_TASK_SUSPEND
+  // a task suspended and resumed within the same tick keeps its phase
+  ARTX_task_suspend(&ut2);
+  ARTX_task_resume(&ut2);
+#endif
+
+#if ARTX_ENABLE_MODES
+  // same intervals and offsets as the task declarations
+  ARTX_mode_switch(&all_tasks);
+#endif
+
+#if TEST_OVERRUN
+  overrun_init();
+#endif
 
 #if ARTX_USE_ROUT_STATE
   ARTX_rout_enable(&run_intr);
@@ -0,0 +1,57 @@
+/*******************************************************************************
+*
+* ARTX budget overrun test task
+*
+********************************************************************************
+*
+* ARTX - A realtime executive library for Atmel AVR microcontrollers
+*
+* Copyright (C) 2007-2015 Marcus Holland-Moritz.
+*
+* ARTX is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* ARTX is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with ARTX.  If not, see <http://www.gnu.org/licenses/>.
+*
+*******************************************************************************/
+
+/*
+ *  An additional interval-1 task with the lowest user priority that
+ *  regularly runs for longer than a tick, so it is caught by the tick
+ *  and overruns its budget while being exactly one interval behind.
+ */
+
+#include "artx/task.h"
+
+void overrun_init(void);
+
+void eat_cycles(uint8_t task, uint16_t num);
+
+ARTX_TASK(ovr,    5,   1, 14); //  2 ms
+
+static uint8_t ovr_runs;
+
+ARTX_ROUT(run_ovr)
+{
+  if ((++ovr_runs & 7) == 0)
+  {
+    eat_cycles(6, 200);
+  }
+}
+
+void overrun_init(void)
+{
+#if !ARTX_USE_AUTO_INIT
+  ARTX_task_init(&ovr);
+#endif
+  ARTX_task_push_rout(&ovr, &run_ovr);
+  ARTX_task_set_budget(&ovr, 1);
+}
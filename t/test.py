@@ -25,10 +25,7 @@
 #
 ################################################################################
 
-from bisect import bisect_right
 from collections import defaultdict
-from elftools.elf.elffile import ELFFile, SymbolTableSection
-from operator import itemgetter
 from unittest import TestSuite, TextTestRunner, TestCase, defaultTestLoader, main
 from sys import argv, stderr
 
@@ -36,52 +33,18 @@ import os
 import pysimulavr
 import re
 import subprocess
+import sys
 
-class SymbolTable(object):
-    def __init__(self, elf):
-        self.__glb = defaultdict(dict)
-        self.__loc = defaultdict(lambda : defaultdict(dict))
-        self.__map = []
-        cur_file = ''
-        with open(elf, 'rb') as f:
-            ef = ELFFile(f)
-            for section in ef.iter_sections():
-                if isinstance(section, SymbolTableSection):
-                    for symbol in section.iter_symbols():
-                        if symbol['st_other']['visibility'] == 'STV_DEFAULT':
-                            stype = symbol['st_info']['type'][4:].lower()
-                            sbind = symbol['st_info']['bind']
-                            if stype == 'file':
-                                cur_file = symbol.name
-                            elif stype != 'notype':
-                                scope = ''
-                                if sbind == 'STB_LOCAL':
-                                    scope = cur_file + ':'
-                                    self.__loc[cur_file][stype][symbol.name] = symbol['st_value']
-                                elif sbind == 'STB_GLOBAL':
-                                    self.__glb[stype][symbol.name] = symbol['st_value']
-                                self.__map.append([
-                                    symbol['st_value'], symbol['st_size'],
-                                    '{0}{1}'.format(scope, symbol.name)])
-        self.__map.sort(key=itemgetter(0))
-        self.__idx = [i[0] for i in self.__map]
-
-    def __call__(self, name, stype='func', scope=None):
-        where = self.__glb if scope is None else self.__loc.get(scope)
-        if where is None:
-            return None
-        return where.get(stype, {}).get(name)
-
-    def addr2sym(self, addr):
-        i = bisect_right(self.__idx, addr)
-        if i:
-            m = self.__map[i-1]
-            off = addr - m[0]
-            if off == 0:
-                return m[2]
-            elif off < m[1]:
-                return '{0}+{1}'.format(m[2], off)
-        return str(addr)
+sys.path.insert(0, os.path.join(os.path.dirname(os.path.abspath(__file__)), '..', 'tools'))
+
+from artxelf import SymbolTable
+from artxtasks import TaskParser
+
+TOOLS = os.path.join(os.path.dirname(os.path.abspath(__file__)), '..', 'tools')
+
+def run_tool(name, *args):
+    return subprocess.check_output([sys.executable, os.path.join(TOOLS, name)] +
+                                   list(args), stderr=subprocess.STDOUT)
 
 class SimulavrAdapter(object):
     DEFAULT_CLOCK_SETTING = 1000 # 1000ns or 1MHz
@@ -114,9 +77,14 @@ class Breakpoint(object):
 
 class DeviceBase(object):
     __TARGET__ = 'artxtest'
+    VARIANT = None
+    DEFINES = {}
+    MAKEVARS = {}
 
     @classmethod
     def target(cls):
+        if cls.VARIANT:
+            return '{0}_{1}_{2}'.format(cls.__TARGET__, cls.DEVICE, cls.VARIANT)
         return '{0}_{1}'.format(cls.__TARGET__, cls.DEVICE)
 
     @classmethod
@@ -125,11 +93,18 @@ class DeviceBase(object):
 
     @classmethod
     def build_target(cls, *args):
-        subprocess.check_output([
-            'make',
-            'TARGET={0}'.format(cls.target()),
-            'MCU={0}'.format(cls.DEVICE),
-        ] + list(args), stderr=subprocess.STDOUT)
+        try:
+            subprocess.check_output([
+                'make',
+                'TARGET={0}'.format(cls.target()),
+                'MCU={0}'.format(cls.DEVICE),
+                'TEST_DEFS={0}'.format(' '.join('-D{0}={1}'.format(k, v)
+                                       for k, v in sorted(cls.DEFINES.items()))),
+            ] + ['{0}={1}'.format(k, v) for k, v in sorted(cls.MAKEVARS.items())]
+              + list(args), stderr=subprocess.STDOUT)
+        except subprocess.CalledProcessError as e:
+            stderr.write("{0}: build failed\n{1}".format(cls.target(), e.output))
+            raise
 
 class TestBaseClass(TestCase, SimulavrAdapter):
     def setUp(self):
@@ -211,6 +186,28 @@ class TestBaseClass(TestCase, SimulavrAdapter):
         addr2 = self.symtab(name) >> 1
         self.assertEqual(addr1, addr2)
 
+    def test_tick_cycles(self):
+        "cycles from the tick interrupt to the highest priority task"
+        self.break_at(self.VECTOR)
+        self.break_at('run_intr', scope='artxtest.c')
+
+        get_ct = self.clock().GetCurrentTime
+        t_end = get_ct() + 1e9
+        t_tick = None
+        cycles = []
+        while get_ct() <= t_end:
+            bp = self.cont()
+            if bp.name == self.VECTOR:
+                t_tick = get_ct()
+            elif t_tick is not None:
+                cycles.append(int(round((get_ct() - t_tick)/float(self.DEFAULT_CLOCK_SETTING))))
+                t_tick = None
+            bp.leave()
+
+        self.assertGreater(len(cycles), 0)
+        stderr.write("\n{0}: {1}..{2} cycles from tick to run_intr\n".format(
+                     self.target(), min(cycles), max(cycles)))
+
     def test_basic_scheduling(self):
         "basic scheduling logic"
         routines = [
@@ -317,6 +314,86 @@ class DeviceTiny85(DeviceBase):
     DEVICE = 'attiny85'
     VECTOR = '__vector_3'
 
+# Variants of the test application that override settings in testconfig.h.
+# All of them must pass the same timing checks as the default build.
+
+class VariantGpior(object):
+    VARIANT = 'gpior'
+    DEFINES = {'ARTX_USE_GPIOR': 1}
+
+class VariantMonitor(object):
+    VARIANT = 'monitor'
+    DEFINES = {'ARTX_ENABLE_MONITOR': 1}
+
+class VariantGpiorMonitor(object):
+    VARIANT = 'gpiormon'
+    DEFINES = {'ARTX_USE_GPIOR': 1, 'ARTX_ENABLE_MONITOR': 1}
+
+class VariantEDF(object):
+    VARIANT = 'edf'
+    DEFINES = {'ARTX_SCHED_EDF': 1}
+
+class VariantTable(object):
+    VARIANT = 'table'
+    DEFINES = {'ARTX_SCHED_TABLE': 1}
+    MAKEVARS = {'TTABLE_SRC': 'artxtest.c'}
+
+class VariantModes(object):
+    VARIANT = 'modes'
+    DEFINES = {'ARTX_ENABLE_MODES': 1}
+
+class VariantSuspend(object):
+    VARIANT = 'suspend'
+    DEFINES = {'ARTX_USE_TASK_SUSPEND': 1}
+
+class VariantPool(object):
+    VARIANT = 'pool'
+    DEFINES = {'ARTX_TASK_POOL_SIZE': 1}
+
+class VariantSporadic(object):
+    VARIANT = 'sporadic'
+    DEFINES = {'ARTX_ENABLE_BUDGET': 1, 'ARTX_ENABLE_SPORADIC': 1}
+
+class VariantAbsRelease(object):
+    VARIANT = 'abs'
+    DEFINES = {'ARTX_USE_ABS_RELEASE': 1, 'ARTX_SCHED_EDF': 1}
+
+class VariantOverrun(object):
+    VARIANT = 'overrun'
+    DEFINES = {'ARTX_USE_ABS_RELEASE': 1, 'ARTX_SCHED_EDF': 1,
+               'ARTX_ENABLE_BUDGET': 1, 'TEST_OVERRUN': 1}
+    MAKEVARS = {'TEST_SRC': 'overrun.c'}
+
+class VariantAutoInit(object):
+    VARIANT = 'autoinit'
+    DEFINES = {'ARTX_USE_AUTO_INIT': 1}
+
+class VariantRomTcb(object):
+    VARIANT = 'romtcb'
+    DEFINES = {'ARTX_USE_ROM_TCB': 1, 'ARTX_USE_AUTO_INIT': 1,
+               'ARTX_USE_SHORT_SCHEDULE': 1}
+
+class VariantShortSchedule(object):
+    VARIANT = 'short'
+    DEFINES = {'ARTX_USE_SHORT_SCHEDULE': 1}
+
+# Only built, not run: all diagnostics enabled at the same time.
+
+class VariantDiagnostics(object):
+    VARIANT = 'diag'
+    DEFINES = {
+        'ARTX_ENABLE_SERIAL': 1,
+        'ARTX_ENABLE_MONITOR': 1,
+        'ARTX_ENABLE_STATS': 1,
+        'ARTX_ENABLE_STACK_CHECK': 1,
+        'ARTX_ENABLE_HISTOGRAM': 1,
+        'ARTX_ENABLE_LATENCY': 1,
+        'ARTX_ENABLE_PROFILE': 1,
+        'ARTX_ENABLE_CLI_PROFILE': 1,
+        'ARTX_ENABLE_TRACE': 1,
+        'ARTX_ENABLE_LOG': 1,
+    }
+
 class TestMega16(TestBaseClass, DeviceMega16):
     pass
 
@@ -332,20 +409,129 @@ class TestMega1284(TestBaseClass, DeviceMega1284):
 class TestTiny85(TestBaseClass, DeviceTiny85):
     pass
 
+class TestMega168Gpior(VariantGpior, TestBaseClass, DeviceMega168):
+    pass
+
+class TestMega324Gpior(VariantGpior, TestBaseClass, DeviceMega324):
+    pass
+
+class TestMega1284Gpior(VariantGpior, TestBaseClass, DeviceMega1284):
+    pass
+
+class TestTiny85Gpior(VariantGpior, TestBaseClass, DeviceTiny85):
+    pass
+
+class TestMega168Monitor(VariantMonitor, TestBaseClass, DeviceMega168):
+    pass
+
+class TestMega324Monitor(VariantMonitor, TestBaseClass, DeviceMega324):
+    pass
+
+class TestMega1284Monitor(VariantMonitor, TestBaseClass, DeviceMega1284):
+    pass
+
+class TestMega168GpiorMonitor(VariantGpiorMonitor, TestBaseClass, DeviceMega168):
+    pass
+
+class TestMega324GpiorMonitor(VariantGpiorMonitor, TestBaseClass, DeviceMega324):
+    pass
+
+class TestMega1284GpiorMonitor(VariantGpiorMonitor, TestBaseClass, DeviceMega1284):
+    pass
+
+class TestMega168EDF(VariantEDF, TestBaseClass, DeviceMega168):
+    pass
+
+class TestMega168Table(VariantTable, TestBaseClass, DeviceMega168):
+    pass
+
+class TestMega168Modes(VariantModes, TestBaseClass, DeviceMega168):
+    pass
+
+class TestMega168Suspend(VariantSuspend, TestBaseClass, DeviceMega168):
+    pass
+
+class TestMega168Pool(VariantPool, TestBaseClass, DeviceMega168):
+    pass
+
+class TestMega168Sporadic(VariantSporadic, TestBaseClass, DeviceMega168):
+    pass
+
+class TestMega168AbsRelease(VariantAbsRelease, TestBaseClass, DeviceMega168):
+    pass
+
+class TestMega168Overrun(VariantOverrun, TestBaseClass, DeviceMega168):
+    pass
+
+class TestMega168AutoInit(VariantAutoInit, TestBaseClass, DeviceMega168):
+    pass
+
+class TestMega168RomTcb(VariantRomTcb, TestBaseClass, DeviceMega168):
+    pass
+
+class TestTiny85ShortSchedule(VariantShortSchedule, TestBaseClass, DeviceTiny85):
+    pass
+
+class BuildMega1284Diagnostics(VariantDiagnostics, DeviceMega1284):
+    pass
+
+class TestTools(TestCase):
+    def test_offset_releases(self):
+        t, = TaskParser().parse('ARTX_TASK_OFFS(t, 0, 4, 16, 10);')
+        self.assertEqual(list(t.releases(20)), [10, 14, 18])
+        self.assertEqual(t.settle(), 7)
+
+    def test_ttgen(self):
+        out = run_tool('artx-ttgen', '-q', 'artxtest.c')
+        self.assertIn('hyperperiod: 800 ticks', out)
+        self.assertIn('artx_tt_loop PROGMEM = 0;', out)
+
+    def test_offsets(self):
+        tasks = TaskParser().parse(run_tool('artx-offsets', '-q', 'artxtest.c'))
+        self.assertEqual([t.name for t in tasks], ['intr', 'ut0', 'ut1', 'ut2', 'ut3'])
+        for t in tasks:
+            self.assertLess(t.offset, t.interval, t.name)
+
 if __name__ == "__main__":
   classes = [
       TestMega16,
       TestMega168,
       TestMega324,
       TestMega1284,
-      TestTiny85
+      TestTiny85,
+      TestMega168Gpior,
+      TestMega324Gpior,
+      TestMega1284Gpior,
+      TestTiny85Gpior,
+      TestMega168Monitor,
+      TestMega324Monitor,
+      TestMega1284Monitor,
+      TestMega168GpiorMonitor,
+      TestMega324GpiorMonitor,
+      TestMega1284GpiorMonitor,
+      TestMega168EDF,
+      TestMega168Table,
+      TestMega168Modes,
+      TestMega168Suspend,
+      TestMega168Pool,
+      TestMega168Sporadic,
+      TestMega168AbsRelease,
+      TestMega168Overrun,
+      TestMega168AutoInit,
+      TestMega168RomTcb,
+      TestTiny85ShortSchedule
+  ]
+  build_only = [
+      BuildMega1284Diagnostics
   ]
   allTestsFrom = defaultTestLoader.loadTestsFromTestCase
   suite = TestSuite()
-  for cls in classes:
+  for cls in classes + build_only:
       cls.build_target('clean')
       cls.build_target()
+  for cls in classes:
       suite.addTests(allTestsFrom(cls))
+  suite.addTests(allTestsFrom(TestTools))
   TextTestRunner(verbosity = 2).run(suite)
-  for cls in classes:
+  for cls in classes + build_only:
       cls.build_target('realclean')
@@ -42,14 +42,100 @@
 # error "TODO: currently unsupported"
 #endif
 
-#define ARTX_ENABLE_TIME 0
-#define ARTX_ENABLE_SPI 0
-#define ARTX_ENABLE_TWI 0
-#define ARTX_ENABLE_SERIAL 0
-#define ARTX_ENABLE_MONITOR 0
-#define ARTX_ENABLE_TICK_SYNC 0
-#define ARTX_USE_ROUT_STATE 0
-#define ARTX_USE_MULTI_ROUT 0
-#define ARTX_ALLOW_NESTED_LOCKS 0
+/* feature settings can be overridden by the test variants */
+
+#ifndef ARTX_ENABLE_TIME
+# define ARTX_ENABLE_TIME 0
+#endif
+#ifndef ARTX_ENABLE_SPI
+# define ARTX_ENABLE_SPI 0
+#endif
+#ifndef ARTX_ENABLE_TWI
+# define ARTX_ENABLE_TWI 0
+#endif
+#ifndef ARTX_ENABLE_SERIAL
+# define ARTX_ENABLE_SERIAL 0
+#endif
+#ifndef ARTX_ENABLE_MONITOR
+# define ARTX_ENABLE_MONITOR 0
+#endif
+#ifndef ARTX_ENABLE_STATS
+# define ARTX_ENABLE_STATS 0
+#endif
+#ifndef ARTX_ENABLE_STACK_CHECK
+# define ARTX_ENABLE_STACK_CHECK 0
+#endif
+#ifndef ARTX_ENABLE_SAMPLING
+# define ARTX_ENABLE_SAMPLING 0
+#endif
+#ifndef ARTX_ENABLE_HISTOGRAM
+# define ARTX_ENABLE_HISTOGRAM 0
+#endif
+#ifndef ARTX_ENABLE_LATENCY
+# define ARTX_ENABLE_LATENCY 0
+#endif
+#ifndef ARTX_ENABLE_PROFILE
+# define ARTX_ENABLE_PROFILE 0
+#endif
+#ifndef ARTX_ENABLE_CLI_PROFILE
+# define ARTX_ENABLE_CLI_PROFILE 0
+#endif
+#ifndef ARTX_ENABLE_TRACE
+# define ARTX_ENABLE_TRACE 0
+#endif
+#ifndef ARTX_ENABLE_LOG
+# define ARTX_ENABLE_LOG 0
+#endif
+#ifndef ARTX_ENABLE_TICK_SYNC
+# define ARTX_ENABLE_TICK_SYNC 0
+#endif
+#ifndef ARTX_USE_ROUT_STATE
+# define ARTX_USE_ROUT_STATE 0
+#endif
+#ifndef ARTX_USE_MULTI_ROUT
+# define ARTX_USE_MULTI_ROUT 0
+#endif
+#ifndef ARTX_ALLOW_NESTED_LOCKS
+# define ARTX_ALLOW_NESTED_LOCKS 0
+#endif
+#ifndef ARTX_SCHED_EDF
+# define ARTX_SCHED_EDF 0
+#endif
+#ifndef ARTX_SCHED_TABLE
+# define ARTX_SCHED_TABLE 0
+#endif
+#ifndef ARTX_ENABLE_MODES
+# define ARTX_ENABLE_MODES 0
+#endif
+#ifndef ARTX_USE_TASK_SUSPEND
+# define ARTX_USE_TASK_SUSPEND 0
+#endif
+#ifndef ARTX_TASK_POOL_SIZE
+# define ARTX_TASK_POOL_SIZE 0
+#endif
+#ifndef ARTX_ENABLE_BUDGET
+# define ARTX_ENABLE_BUDGET 0
+#endif
+#ifndef ARTX_ENABLE_SPORADIC
+# define ARTX_ENABLE_SPORADIC 0
+#endif
+#ifndef ARTX_USE_ABS_RELEASE
+# define ARTX_USE_ABS_RELEASE 0
+#endif
+#ifndef ARTX_USE_AUTO_INIT
+# define ARTX_USE_AUTO_INIT 0
+#endif
+#ifndef ARTX_USE_ROM_TCB
+# define ARTX_USE_ROM_TCB 0
+#endif
+#ifndef ARTX_USE_SHORT_SCHEDULE
+# define ARTX_USE_SHORT_SCHEDULE 0
+#endif
+#ifndef ARTX_USE_GPIOR
+# define ARTX_USE_GPIOR 0
+#endif
+#ifndef ARTX_ENABLE_ISR_STACK
+# define ARTX_ENABLE_ISR_STACK 0
+#endif
 
 #endif
@@ -0,0 +1,117 @@
+# -*- coding: UTF-8 -*-
+
+################################################################################
+#
+# ARTX ELF file helpers
+#
+################################################################################
+#
+# ARTX - A realtime executive library for Atmel AVR microcontrollers
+#
+# Copyright (C) 2007-2015 Marcus Holland-Moritz.
+#
+# ARTX is free software: you can redistribute it and/or modify
+# it under the terms of the GNU General Public License as published by
+# the Free Software Foundation, either version 3 of the License, or
+# (at your option) any later version.
+#
+# ARTX is distributed in the hope that it will be useful,
+# but WITHOUT ANY WARRANTY; without even the implied warranty of
+# MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+# GNU General Public License for more details.
+#
+# You should have received a copy of the GNU General Public License
+# along with ARTX.  If not, see <http://www.gnu.org/licenses/>.
+#
+################################################################################
+
+"""
+Symbol and flash lookup in ARTX application ELF files, used by the test suite
+and the host tools.
+"""
+
+from bisect import bisect_right
+from collections import defaultdict
+from elftools.elf.constants import SH_FLAGS
+from elftools.elf.elffile import ELFFile, SymbolTableSection
+from operator import itemgetter
+
+class SymbolTable(object):
+    def __init__(self, elf):
+        self.__glb = defaultdict(dict)
+        self.__loc = defaultdict(lambda : defaultdict(dict))
+        self.__map = []
+        cur_file = ''
+        with open(elf, 'rb') as f:
+            ef = ELFFile(f)
+            for section in ef.iter_sections():
+                if isinstance(section, SymbolTableSection):
+                    for symbol in section.iter_symbols():
+                        if symbol['st_other']['visibility'] == 'STV_DEFAULT':
+                            stype = symbol['st_info']['type'][4:].lower()
+                            sbind = symbol['st_info']['bind']
+                            if stype == 'file':
+                                cur_file = symbol.name
+                            elif stype != 'notype':
+                                scope = ''
+                                if sbind == 'STB_LOCAL':
+                                    scope = cur_file + ':'
+                                    self.__loc[cur_file][stype][symbol.name] = symbol['st_value']
+                                elif sbind == 'STB_GLOBAL':
+                                    self.__glb[stype][symbol.name] = symbol['st_value']
+                                self.__map.append([
+                                    symbol['st_value'], symbol['st_size'],
+                                    '{0}{1}'.format(scope, symbol.name)])
+        self.__map.sort(key=itemgetter(0))
+        self.__idx = [i[0] for i in self.__map]
+
+    def __call__(self, name, stype='func', scope=None):
+        where = self.__glb if scope is None else self.__loc.get(scope)
+        if where is None:
+            return None
+        return where.get(stype, {}).get(name)
+
+    def addr2sym(self, addr):
+        i = bisect_right(self.__idx, addr)
+        if i:
+            m = self.__map[i-1]
+            off = addr - m[0]
+            if off == 0:
+                return m[2]
+            elif off < m[1]:
+                return '{0}+{1}'.format(m[2], off)
+        return str(addr)
+
+# RAM addresses are offset by this amount in AVR ELF files
+DATA_OFFSET = 0x800000
+
+def data_symbol(symtab, addr):
+    """Symbolize a RAM address, e.g. a pointer to a TCB."""
+    return symtab.addr2sym(DATA_OFFSET + addr)
+
+def code_symbol(symtab, addr):
+    """Symbolize a function pointer, which holds a word address."""
+    return symtab.addr2sym(2*addr)
+
+class FlashImage(object):
+    """
+    Gives access to the initialized contents of program memory, e.g.
+    to read strings placed in flash using PROGMEM or PSTR().
+    """
+
+    def __init__(self, elf):
+        self.__sections = []
+        with open(elf, 'rb') as f:
+            ef = ELFFile(f)
+            for section in ef.iter_sections():
+                if (section['sh_type'] == 'SHT_PROGBITS' and section['sh_flags'] & SH_FLAGS.SHF_ALLOC
+                        and section['sh_addr'] < DATA_OFFSET):
+                    self.__sections.append((section['sh_addr'], section.data()))
+
+    def string(self, addr):
+        """Read the NUL terminated string at the given byte address."""
+        for base, data in self.__sections:
+            if base <= addr < base + len(data):
+                end = data.find(b'\0', addr - base)
+                return data[addr - base:end if end >= 0 else len(data)].decode('latin-1')
+        return None
@@ -0,0 +1,215 @@
+# -*- coding: UTF-8 -*-
+
+################################################################################
+#
+# ARTX monitor stream parser
+#
+################################################################################
+#
+# ARTX - A realtime executive library for Atmel AVR microcontrollers
+#
+# Copyright (C) 2007-2015 Marcus Holland-Moritz.
+#
+# ARTX is free software: you can redistribute it and/or modify
+# it under the terms of the GNU General Public License as published by
+# the Free Software Foundation, either version 3 of the License, or
+# (at your option) any later version.
+#
+# ARTX is distributed in the hope that it will be useful,
+# but WITHOUT ANY WARRANTY; without even the implied warranty of
+# MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+# GNU General Public License for more details.
+#
+# You should have received a copy of the GNU General Public License
+# along with ARTX.  If not, see <http://www.gnu.org/licenses/>.
+#
+################################################################################
+
+"""
+Parser for the monitoring information sent by ARTX_ENABLE_MONITOR,
+used by the host tools that evaluate single blocks of the monitor
+stream. tools/ARTXmon has its own parser for the task information.
+Also parses the sample counts sent by ARTX_ENABLE_SAMPLING.
+"""
+
+from __future__ import print_function
+
+import struct
+
+MARKER = b'ARTX'
+
+HEADER = struct.Struct('<BBBBHHHHIB')
+
+# header fields added in protocol version 7
+HEADER_V7 = struct.Struct('<BB')
+
+# blocks holding a table: entry count, 16-bit overflow counter, entries
+TABLES = {
+    b'P': 4,    # program counter samples
+    b'C': 20,   # interrupt disabled windows
+}
+
+SAMPLING_MARKER = b'ARTS'
+
+SAMPLING_HEADER = struct.Struct('<BBH')
+
+class Frame(object):
+    def __init__(self, header):
+        (self.version, self.hdr_size, self.tcb_size, self.rcb_size,
+         self.nom_tick_duration, self.cur_tick_duration, self.tick_prescaler,
+         self.monitor_interval, self.clock_frequency, self.cyc_size) = header
+        self.info_size = 0
+        self.intervals = 1
+        self.blocks = []
+
+class MonitorParser(object):
+    """
+    Splits a byte stream into monitor frames. Each frame holds the
+    header fields and a list of (block, data) tuples. Everything
+    outside of monitor frames is skipped, as are frames containing
+    unknown blocks.
+    """
+
+    def __init__(self):
+        self.__data = b''
+
+    @staticmethod
+    def __string(data, pos):
+        end = data.find(b'\0', pos)
+        return -1 if end < 0 else end + 1
+
+    def __block(self, frame, data, pos):
+        """Returns the end of the block at pos, -1 if incomplete, None if unknown."""
+        block = data[pos:pos + 1]
+        pos += 1
+        if block in (b'T', b'R'):
+            pos += (frame.tcb_size if block == b'T' else frame.rcb_size) + frame.info_size
+            return -1 if pos > len(data) else self.__string(data, pos)
+        if block == b'M':
+            return self.__string(data, pos)
+        if block == b'I':
+            pos += frame.cyc_size
+            return -1 if pos > len(data) else self.__string(data, pos)
+        if block == b'K':
+            return pos + frame.cyc_size
+        if block == b'H':
+            if pos + 2 > len(data):
+                return -1
+            return pos + 2 + 2*struct.unpack('<B', data[pos:pos + 1])[0]
+        if block == b'J':
+            if pos + 1 > len(data):
+                return -1
+            return pos + 1 + struct.unpack('<B', data[pos:pos + 1])[0]
+        if block in TABLES:
+            if pos + 3 > len(data):
+                return -1
+            return pos + 3 + TABLES[block]*struct.unpack('<B', data[pos:pos + 1])[0]
+        if block == b'E':
+            return pos
+        return None
+
+    def feed(self, data):
+        self.__data += data
+        frames = []
+        while True:
+            ix = self.__data.find(MARKER)
+            if ix < 0:
+                self.__data = self.__data[-(len(MARKER) - 1):]
+                break
+            data = self.__data[ix + len(MARKER):]
+            if len(data) < HEADER.size:
+                self.__data = self.__data[ix:]
+                break
+            frame = Frame(HEADER.unpack(data[:HEADER.size]))
+            if frame.hdr_size >= HEADER.size + HEADER_V7.size:
+                if len(data) < HEADER.size + HEADER_V7.size:
+                    self.__data = self.__data[ix:]
+                    break
+                frame.info_size, frame.intervals = HEADER_V7.unpack(
+                    data[HEADER.size:HEADER.size + HEADER_V7.size])
+            pos = frame.hdr_size
+            complete = False
+            while pos < len(data):
+                end = self.__block(frame, data, pos)
+                if end is None:
+                    # not a valid frame
+                    frame = None
+                    break
+                if end < 0 or end > len(data):
+                    break
+                frame.blocks.append((data[pos:pos + 1].decode('latin-1'), data[pos + 1:end]))
+                pos = end
+                if frame.blocks[-1][0] == 'E':
+                    complete = True
+                    break
+            if frame is None:
+                self.__data = data
+                continue
+            if not complete:
+                self.__data = self.__data[ix:]
+                break
+            frames.append(frame)
+            self.__data = data[pos:]
+        return frames
+
+class SamplingFrame(object):
+    def __init__(self, header):
+        self.version, self.hdr_size, self.interval = header
+        # list of (name, samples, [(routine, samples), ...])
+        self.tasks = []
+
+class SamplingParser(object):
+    """
+    Splits a byte stream into sampling monitor frames. Everything
+    outside of sampling frames is skipped, as are frames containing
+    unknown blocks.
+    """
+
+    def __init__(self):
+        self.__data = b''
+
+    @staticmethod
+    def __parse(data):
+        """Returns (frame, end) of the frame in data, (None, -1) if incomplete."""
+        if len(data) < SAMPLING_HEADER.size:
+            return None, -1
+        frame = SamplingFrame(SAMPLING_HEADER.unpack(data[:SAMPLING_HEADER.size]))
+        pos = frame.hdr_size
+        while pos < len(data):
+            block = data[pos:pos + 1]
+            if block == b'E':
+                return frame, pos + 1
+            if block not in (b'T', b'R'):
+                return None, None
+            end = data.find(b'\0', pos + 3)
+            if end < 0:
+                break
+            samples = struct.unpack('<H', data[pos + 1:pos + 3])[0]
+            name = data[pos + 3:end].decode('latin-1')
+            if block == b'T':
+                frame.tasks.append((name, samples, []))
+            elif frame.tasks:
+                frame.tasks[-1][2].append((name, samples))
+            pos = end + 1
+        return None, -1
+
+    def feed(self, data):
+        self.__data += data
+        frames = []
+        while True:
+            ix = self.__data.find(SAMPLING_MARKER)
+            if ix < 0:
+                self.__data = self.__data[-(len(SAMPLING_MARKER) - 1):]
+                break
+            data = self.__data[ix + len(SAMPLING_MARKER):]
+            frame, end = self.__parse(data)
+            if end is None:
+                # not a valid frame
+                self.__data = data
+                continue
+            if end < 0:
+                self.__data = self.__data[ix:]
+                break
+            frames.append(frame)
+            self.__data = data[end:]
+        return frames
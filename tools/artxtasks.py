@@ -0,0 +1,113 @@
+# -*- coding: UTF-8 -*-
+
+################################################################################
+#
+# ARTX task declaration parser
+#
+################################################################################
+#
+# ARTX - A realtime executive library for Atmel AVR microcontrollers
+#
+# Copyright (C) 2007-2015 Marcus Holland-Moritz.
+#
+# ARTX is free software: you can redistribute it and/or modify
+# it under the terms of the GNU General Public License as published by
+# the Free Software Foundation, either version 3 of the License, or
+# (at your option) any later version.
+#
+# ARTX is distributed in the hope that it will be useful,
+# but WITHOUT ANY WARRANTY; without even the implied warranty of
+# MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+# GNU General Public License for more details.
+#
+# You should have received a copy of the GNU General Public License
+# along with ARTX.  If not, see <http://www.gnu.org/licenses/>.
+#
+################################################################################
+
+from __future__ import print_function
+
+import re
+
+try:
+    from math import gcd
+except ImportError:
+    from fractions import gcd
+
+class Task(object):
+    def __init__(self, name, prio, interval, stack, offset, line, args=None):
+        self.name = name
+        self.prio = prio
+        self.interval = interval
+        self.stack = stack
+        self.offset = offset
+        self.line = line
+        self.args = args
+
+    def releases(self, end):
+        return range(self.offset, end, self.interval)
+
+    def settle(self):
+        # first tick from which the releases repeat with the interval,
+        # i.e. an offset larger than the interval is a one-time delay
+        return max(0, self.offset - self.interval + 1)
+
+class TaskParser(object):
+    """
+    Extracts ARTX_TASK() and ARTX_TASK_OFFS() declarations from C
+    source files. Arguments must either be integer expressions or
+    names of macros passed in via `defines`.
+    """
+
+    __DECL = re.compile(r'^\s*ARTX_TASK(_OFFS)?\s*\(([^)]*)\)', re.M)
+    __COMMENT = re.compile(r'/\*.*?\*/|//[^\n]*', re.S)
+    __EXPR = re.compile(r'^[\d\s()+\-*/%<>xXa-fA-FuUlL]+$')
+
+    def __init__(self, defines=None):
+        self.defines = dict(defines or {})
+
+    def __eval(self, arg, what, line):
+        arg = arg.strip()
+        while arg in self.defines:
+            arg = str(self.defines[arg]).strip()
+        if not self.__EXPR.match(arg):
+            raise ValueError('line {0}: cannot evaluate {1} "{2}"'.format(line, what, arg))
+        return int(eval(re.sub(r'(?<=[\dA-Fa-f])[uUlL]+', '', arg).replace('/', '//')))
+
+    def parse(self, text):
+        text = self.__COMMENT.sub(lambda m: '\n'*m.group(0).count('\n'), text)
+        tasks = []
+        for m in self.__DECL.finditer(text):
+            line = text.count('\n', 0, m.start()) + 1
+            args = m.group(2).split(',')
+            want = 5 if m.group(1) else 4
+            if len(args) != want:
+                raise ValueError('line {0}: expected {1} arguments'.format(line, want))
+            name = args[0].strip()
+            prio, interval, stack = [self.__eval(a, w, line) for a, w in
+                                     zip(args[1:4], ['priority', 'interval', 'stack size'])]
+            offset = self.__eval(args[4], 'offset', line) if m.group(1) else 0
+            if interval <= 0:
+                raise ValueError('line {0}: invalid interval for task {1}'.format(line, name))
+            tasks.append(Task(name, prio, interval, stack, offset, line,
+                              [a.strip() for a in args[:4]]))
+        if not tasks:
+            raise ValueError('no task declarations found')
+        return sorted(tasks, key=lambda t: t.prio)
+
+    def parse_file(self, path):
+        with open(path) as f:
+            return self.parse(f.read())
+
+def hyperperiod(tasks):
+    h = 1
+    for t in tasks:
+        h = h*t.interval//gcd(h, t.interval)
+    return h
+
+def parse_defines(args):
+    defines = {}
+    for d in args or []:
+        name, _, value = d.partition('=')
+        defines[name] = value or '1'
+    return defines